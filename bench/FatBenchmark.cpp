@@ -0,0 +1,382 @@
+/**************************************************************************
+ * Benchmarks the Fat16FileManager against a RamStorageMedia, optionally
+ * with a simulated per command latency and bandwidth. Measures mount
+ * time, sequential write and read throughput, createEntry latency as
+ * the volume fills up, deleteEntry on long cluster chains and the cost
+ * of listing a directory. Results are written to stdout as CSV, one
+ * row per measurement, alongside the number of storage media accesses
+ * each took, which doesn't depend on the machine the run was on.
+**************************************************************************/
+
+#include "Fat16FileManager.hpp"
+#include "RamStorageMedia.hpp"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_SECTOR_SIZE 		512
+#define BENCH_NUM_MOUNTS 		10
+#define BENCH_NUM_LISTINGS 		100
+#define BENCH_NUM_LISTING_ENTRIES 	256
+#define BENCH_NUM_CREATES_PER_LEVEL 	32
+
+struct BenchConfig
+{
+	unsigned int sizeInMB;
+	unsigned int numSectorsPerCluster;
+	unsigned int latencyInMicroseconds;
+	unsigned int bandwidthInKBPerSecond;
+	unsigned int fileSizeInKB;
+	unsigned int chunkSizeInKB;
+};
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double getElapsedMicroseconds (const BenchClock::time_point& startTime)
+{
+	return std::chrono::duration<double, std::micro>( BenchClock::now() - startTime ).count();
+}
+
+static void printResult (const char* benchmark, const char* parameter, double value, const char* unit)
+{
+	printf( "%s,%s,%.3f,%s\n", benchmark, parameter, value, unit );
+}
+
+static void printMediaCounts (const char* benchmark, const char* parameter, const RamStorageMedia& media)
+{
+	char countName[64];
+
+	snprintf( countName, sizeof(countName), "%s_media_reads", benchmark );
+	printResult( countName, parameter, media.getNumReads(), "accesses" );
+	snprintf( countName, sizeof(countName), "%s_media_writes", benchmark );
+	printResult( countName, parameter, media.getNumWrites(), "accesses" );
+}
+
+static void makeFilename (char* filename, const char* prefix, unsigned int fileNum)
+{
+	snprintf( filename, FAT16_FILENAME_SIZE + 1, "%s%u", prefix, fileNum );
+}
+
+// writes a file of the given size in chunks through writeToEntry, returns false if the volume fills up first
+static bool writeFile (Fat16FileManager& fileManager, const char* filename, unsigned int sizeInBytes, unsigned int chunkSizeInBytes)
+{
+	Fat16Entry entry( filename, "BIN" );
+	Fat16FileHandle handle;
+	if ( ! fileManager.createEntry(entry, handle) ) return false;
+
+	SharedData<uint8_t> chunk = SharedData<uint8_t>::MakeSharedData( chunkSizeInBytes );
+	for ( unsigned int byte = 0; byte < chunkSizeInBytes; byte++ )
+	{
+		chunk[byte] = static_cast<uint8_t>( byte * 31 );
+	}
+
+	unsigned int numBytesLeft = sizeInBytes;
+	while ( numBytesLeft >= chunkSizeInBytes )
+	{
+		if ( ! fileManager.writeToEntry(handle, chunk) ) return false;
+		numBytesLeft -= chunkSizeInBytes;
+	}
+
+	const unsigned int numWholeSectorBytes = numBytesLeft - ( numBytesLeft % BENCH_SECTOR_SIZE );
+	if ( numWholeSectorBytes > 0 )
+	{
+		SharedData<uint8_t> sectors = SharedData<uint8_t>::MakeSharedData( numWholeSectorBytes );
+		memset( &sectors[0], 0, numWholeSectorBytes );
+		if ( ! fileManager.writeToEntry(handle, sectors) ) return false;
+		numBytesLeft -= numWholeSectorBytes;
+	}
+
+	if ( numBytesLeft > 0 )
+	{
+		SharedData<uint8_t> tail = SharedData<uint8_t>::MakeSharedData( numBytesLeft );
+		memset( &tail[0], 0, numBytesLeft );
+
+		return fileManager.flushToEntry( handle, tail );
+	}
+
+	return fileManager.finalizeEntry( handle );
+}
+
+static bool deleteFile (Fat16FileManager& fileManager, const char* filename)
+{
+	unsigned int entryNum = 0;
+	if ( ! fileManager.findEntry(filename, "BIN", entryNum) ) return false;
+
+	return fileManager.deleteEntry( entryNum );
+}
+
+static bool benchmarkSequentialWrite (Fat16FileManager& fileManager, RamStorageMedia& media, const BenchConfig& config)
+{
+	const unsigned int fileSizeInBytes = config.fileSizeInKB * 1024;
+
+	media.resetCounts();
+	const BenchClock::time_point startTime = BenchClock::now();
+	if ( ! writeFile(fileManager, "SEQ", fileSizeInBytes, config.chunkSizeInKB * 1024) ) return false;
+	const double elapsedMicroseconds = getElapsedMicroseconds( startTime );
+
+	printResult( "seq_write", "", fileSizeInBytes / elapsedMicroseconds, "MB/s" );
+	printMediaCounts( "seq_write", "", media );
+
+	return true;
+}
+
+static bool benchmarkSequentialRead (Fat16FileManager& fileManager, RamStorageMedia& media)
+{
+	unsigned int entryNum = 0;
+	if ( ! fileManager.findEntry("SEQ", "BIN", entryNum) ) return false;
+	const Fat16Entry entry = fileManager.selectEntry( entryNum );
+
+	media.resetCounts();
+	const BenchClock::time_point startTime = BenchClock::now();
+	Fat16FileHandle handle;
+	if ( ! fileManager.readEntry(entry, handle) ) return false;
+
+	uint64_t numBytesRead = 0;
+	SharedData<uint8_t> sector = fileManager.getSelectedFileNextSector( handle );
+	while ( sector.getSizeInBytes() > 0 )
+	{
+		numBytesRead += sector.getSizeInBytes();
+		sector = fileManager.getSelectedFileNextSector( handle );
+	}
+	const double elapsedMicroseconds = getElapsedMicroseconds( startTime );
+
+	printResult( "seq_read", "", numBytesRead / elapsedMicroseconds, "MB/s" );
+	printMediaCounts( "seq_read", "", media );
+
+	return numBytesRead >= entry.getFileSizeInBytes();
+}
+
+static void benchmarkMount (RamStorageMedia& media)
+{
+	const FatMountPolicy mountPolicies[] = { FatMountPolicy::EAGER, FatMountPolicy::LAZY };
+	const char* mountPolicyNames[] = { "eager", "lazy" };
+
+	for ( unsigned int policy = 0; policy < 2; policy++ )
+	{
+		media.resetCounts();
+		const BenchClock::time_point startTime = BenchClock::now();
+		for ( unsigned int mount = 0; mount < BENCH_NUM_MOUNTS; mount++ )
+		{
+			Fat16FileManager fileManager( media, nullptr, FAT_SECTOR_CACHE_WHOLE_FAT, nullptr, mountPolicies[policy] );
+		}
+		const double elapsedMicroseconds = getElapsedMicroseconds( startTime );
+
+		printResult( "mount", mountPolicyNames[policy], elapsedMicroseconds / BENCH_NUM_MOUNTS, "us" );
+		printResult( "mount_media_reads", mountPolicyNames[policy], static_cast<double>(media.getNumReads()) / BENCH_NUM_MOUNTS,
+				"accesses" );
+	}
+}
+
+static bool benchmarkDirectoryListing (Fat16FileManager& fileManager, RamStorageMedia& media)
+{
+	char filename[FAT16_FILENAME_SIZE + 1];
+	SharedData<uint8_t> fileData = SharedData<uint8_t>::MakeSharedData( 16 );
+	memset( &fileData[0], 0, 16 );
+	for ( unsigned int fileNum = 0; fileNum < BENCH_NUM_LISTING_ENTRIES; fileNum++ )
+	{
+		makeFilename( filename, "LS", fileNum );
+		Fat16Entry entry( filename, "BIN" );
+		Fat16FileHandle handle;
+		if ( ! fileManager.createEntry(entry, handle) || ! fileManager.flushToEntry(handle, fileData) ) return false;
+	}
+
+	// listing a directory already in memory
+	char displayName[FAT16_FILENAME_SIZE + FAT16_EXTENSION_SIZE + 2];
+	unsigned int numEntriesListed = 0;
+	BenchClock::time_point startTime = BenchClock::now();
+	for ( unsigned int listing = 0; listing < BENCH_NUM_LISTINGS; listing++ )
+	{
+		Fat16DirectoryView view = fileManager.getCurrentDirectoryView( true );
+		for ( unsigned int viewEntryNum = 0; viewEntryNum < view.getNumEntries(); viewEntryNum++ )
+		{
+			view.getEntry( viewEntryNum ).getFilenameDisplay( displayName );
+			numEntriesListed++;
+		}
+	}
+	double elapsedMicroseconds = getElapsedMicroseconds( startTime );
+	printResult( "dir_list_view", "", elapsedMicroseconds / BENCH_NUM_LISTINGS, "us" );
+	printResult( "dir_list_view_entries", "", static_cast<double>(numEntriesListed) / BENCH_NUM_LISTINGS, "entries" );
+
+	// reading the directory back from the storage media and listing it through the entry objects
+	media.resetCounts();
+	startTime = BenchClock::now();
+	for ( unsigned int listing = 0; listing < BENCH_NUM_LISTINGS; listing++ )
+	{
+		fileManager.returnToRoot();
+		std::vector<Fat16Entry*>& entries = fileManager.getCurrentDirectoryEntries();
+		for ( Fat16Entry* entry : entries )
+		{
+			numEntriesListed += ( entry->isUnusedEntry() ) ? 0 : 1;
+		}
+	}
+	elapsedMicroseconds = getElapsedMicroseconds( startTime );
+	printResult( "dir_reload_and_list", "", elapsedMicroseconds / BENCH_NUM_LISTINGS, "us" );
+	printResult( "dir_reload_and_list_media_reads", "", static_cast<double>(media.getNumReads()) / BENCH_NUM_LISTINGS, "accesses" );
+
+	for ( unsigned int fileNum = 0; fileNum < BENCH_NUM_LISTING_ENTRIES; fileNum++ )
+	{
+		makeFilename( filename, "LS", fileNum );
+		if ( ! deleteFile(fileManager, filename) ) return false;
+	}
+
+	return true;
+}
+
+static bool benchmarkDeleteLongChains (Fat16FileManager& fileManager, RamStorageMedia& media, const BenchConfig& config)
+{
+	// files of a 64th, a 16th and a quarter of the volume
+	const unsigned int volumeSizeInBytes = config.sizeInMB * 1024 * 1024;
+	const unsigned int clusterSizeInBytes = config.numSectorsPerCluster * BENCH_SECTOR_SIZE;
+	const unsigned int volumeFractions[] = { 64, 16, 4 };
+
+	for ( unsigned int fraction : volumeFractions )
+	{
+		const unsigned int fileSizeInBytes = volumeSizeInBytes / fraction;
+		if ( ! writeFile(fileManager, "CHAIN", fileSizeInBytes, config.chunkSizeInKB * 1024) ) return false;
+
+		char parameter[32];
+		snprintf( parameter, sizeof(parameter), "%u_clusters", (fileSizeInBytes + clusterSizeInBytes - 1) / clusterSizeInBytes );
+
+		media.resetCounts();
+		const BenchClock::time_point startTime = BenchClock::now();
+		if ( ! deleteFile(fileManager, "CHAIN") ) return false;
+		const double elapsedMicroseconds = getElapsedMicroseconds( startTime );
+
+		printResult( "delete", parameter, elapsedMicroseconds, "us" );
+		printMediaCounts( "delete", parameter, media );
+	}
+
+	return true;
+}
+
+static bool benchmarkCreateByFullness (Fat16FileManager& fileManager, RamStorageMedia& media, const BenchConfig& config)
+{
+	const unsigned int percentagesFull[] = { 0, 25, 50, 75, 90 };
+	const unsigned int clusterSizeInBytes = config.numSectorsPerCluster * BENCH_SECTOR_SIZE;
+	const unsigned int numClusters = fileManager.getNumFreeClusters();
+	unsigned int numFillFiles = 0;
+	char filename[FAT16_FILENAME_SIZE + 1];
+
+	SharedData<uint8_t> fileData = SharedData<uint8_t>::MakeSharedData( 16 );
+	memset( &fileData[0], 0, 16 );
+
+	for ( unsigned int percentageFull : percentagesFull )
+	{
+		// fill the volume up to the percentage with one more file
+		const unsigned int numFreeClustersWanted = numClusters - ( (static_cast<uint64_t>(numClusters) * percentageFull) / 100 );
+		const unsigned int numFreeClusters = fileManager.getNumFreeClusters();
+		if ( numFreeClusters > numFreeClustersWanted )
+		{
+			makeFilename( filename, "FILL", numFillFiles++ );
+			if ( ! writeFile(fileManager, filename, (numFreeClusters - numFreeClustersWanted) * clusterSizeInBytes,
+						config.chunkSizeInKB * 1024) )
+			{
+				return false;
+			}
+		}
+
+		Fat16FileHandle handles[BENCH_NUM_CREATES_PER_LEVEL];
+		char parameter[32];
+		snprintf( parameter, sizeof(parameter), "%u_percent_full", percentageFull );
+
+		media.resetCounts();
+		const BenchClock::time_point startTime = BenchClock::now();
+		for ( unsigned int fileNum = 0; fileNum < BENCH_NUM_CREATES_PER_LEVEL; fileNum++ )
+		{
+			makeFilename( filename, "NEW", fileNum );
+			if ( ! fileManager.createEntry(Fat16Entry(filename, "BIN"), handles[fileNum]) ) return false;
+		}
+		const double elapsedMicroseconds = getElapsedMicroseconds( startTime );
+
+		printResult( "create", parameter, elapsedMicroseconds / BENCH_NUM_CREATES_PER_LEVEL, "us" );
+		printMediaCounts( "create", parameter, media );
+
+		for ( unsigned int fileNum = 0; fileNum < BENCH_NUM_CREATES_PER_LEVEL; fileNum++ )
+		{
+			makeFilename( filename, "NEW", fileNum );
+			if ( ! fileManager.flushToEntry(handles[fileNum], fileData) || ! deleteFile(fileManager, filename) ) return false;
+		}
+	}
+
+	return true;
+}
+
+static bool parseArguments (int argc, char** argv, BenchConfig& config)
+{
+	for ( int arg = 1; arg + 1 < argc; arg += 2 )
+	{
+		const unsigned int value = static_cast<unsigned int>( strtoul(argv[arg + 1], nullptr, 10) );
+
+		if ( strcmp(argv[arg], "--size-mb") == 0 ) config.sizeInMB = value;
+		else if ( strcmp(argv[arg], "--sectors-per-cluster") == 0 ) config.numSectorsPerCluster = value;
+		else if ( strcmp(argv[arg], "--latency-us") == 0 ) config.latencyInMicroseconds = value;
+		else if ( strcmp(argv[arg], "--bandwidth-kbps") == 0 ) config.bandwidthInKBPerSecond = value;
+		else if ( strcmp(argv[arg], "--file-size-kb") == 0 ) config.fileSizeInKB = value;
+		else if ( strcmp(argv[arg], "--chunk-kb") == 0 ) config.chunkSizeInKB = value;
+		else return false;
+	}
+
+	// arguments come in pairs, and chunks are written with writeToEntry so need to be whole sectors
+	return ( argc % 2 == 1 ) && config.chunkSizeInKB > 0 && config.fileSizeInKB > 0;
+}
+
+int main (int argc, char** argv)
+{
+	BenchConfig config;
+	config.sizeInMB = 64;
+	config.numSectorsPerCluster = 4;
+	config.latencyInMicroseconds = 0;
+	config.bandwidthInKBPerSecond = 0;
+	config.fileSizeInKB = 4096;
+	config.chunkSizeInKB = 16;
+
+	if ( ! parseArguments(argc, argv, config) )
+	{
+		fprintf( stderr, "usage: %s [--size-mb n] [--sectors-per-cluster n] [--latency-us n] [--bandwidth-kbps n] "
+				"[--file-size-kb n] [--chunk-kb n]\n", argv[0] );
+		return 2;
+	}
+
+	RamStorageMedia media( config.sizeInMB * 1024 * 1024 );
+	if ( ! media.formatFat16(config.numSectorsPerCluster) )
+	{
+		fprintf( stderr, "a %uMB volume with %u sectors per cluster can't be formatted as FAT16\n", config.sizeInMB,
+				config.numSectorsPerCluster );
+		return 2;
+	}
+	media.setLatency( config.latencyInMicroseconds, config.bandwidthInKBPerSecond );
+
+	printf( "benchmark,parameter,value,unit\n" );
+	printResult( "config", "size", config.sizeInMB, "MB" );
+	printResult( "config", "cluster_size", config.numSectorsPerCluster * BENCH_SECTOR_SIZE, "bytes" );
+	printResult( "config", "latency", config.latencyInMicroseconds, "us" );
+	printResult( "config", "bandwidth", config.bandwidthInKBPerSecond, "KB/s" );
+
+	bool succeeded = true;
+	{
+		Fat16FileManager fileManager( media );
+		succeeded = fileManager.isValidFatFileSystem()
+				&& benchmarkSequentialWrite( fileManager, media, config )
+				&& benchmarkSequentialRead( fileManager, media );
+	}
+
+	if ( succeeded )
+	{
+		benchmarkMount( media );
+
+		Fat16FileManager fileManager( media );
+		succeeded = benchmarkDirectoryListing( fileManager, media )
+				&& benchmarkDeleteLongChains( fileManager, media, config )
+				&& benchmarkCreateByFullness( fileManager, media, config );
+	}
+
+	if ( ! succeeded )
+	{
+		fprintf( stderr, "a benchmark failed to run to completion\n" );
+		return 1;
+	}
+
+	return 0;
+}
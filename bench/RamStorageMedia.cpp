@@ -0,0 +1,179 @@
+#include "RamStorageMedia.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+#include "BootSector.hpp"
+
+#define RAM_MEDIA_SECTOR_SIZE 			512
+#define RAM_MEDIA_NUM_RESERVED_SECTORS 		1
+#define RAM_MEDIA_NUM_FATS 			2
+#define RAM_MEDIA_NUM_ROOT_ENTRIES 		512
+#define RAM_MEDIA_MIN_FAT16_CLUSTERS 		4085 // anything with fewer clusters is FAT12
+#define RAM_MEDIA_MAX_FAT16_CLUSTERS 		65524
+
+static void writeLittleEndian (uint8_t* data, uint32_t value, unsigned int numBytes)
+{
+	for ( unsigned int byte = 0; byte < numBytes; byte++ )
+	{
+		data[byte] = static_cast<uint8_t>( value >> (byte * 8) );
+	}
+}
+
+RamStorageMedia::RamStorageMedia (unsigned int sizeInBytes, unsigned int latencyInMicroseconds, unsigned int bandwidthInKBPerSecond) :
+	m_Data( sizeInBytes, 0 ),
+	m_LatencyInMicroseconds( latencyInMicroseconds ),
+	m_BandwidthInKBPerSecond( bandwidthInKBPerSecond ),
+	m_Mutex(),
+	m_NumReads( 0 ),
+	m_NumWrites( 0 ),
+	m_NumBytesRead( 0 ),
+	m_NumBytesWritten( 0 )
+{
+}
+
+void RamStorageMedia::writeToMedia (const SharedData<uint8_t>& data, const unsigned int offsetInBytes)
+{
+	std::lock_guard<std::mutex> guard( m_Mutex );
+
+	// a single device handles one command at a time, so the time is taken with the lock held
+	this->simulateAccessTime( data.getSizeInBytes() );
+
+	m_NumWrites++;
+	m_NumBytesWritten += data.getSizeInBytes();
+
+	if ( offsetInBytes >= m_Data.size() ) return;
+
+	const size_t numBytesToWrite = std::min<size_t>( data.getSizeInBytes(), m_Data.size() - offsetInBytes );
+	if ( numBytesToWrite > 0 )
+	{
+		memcpy( &m_Data[offsetInBytes], &data[0], numBytesToWrite );
+	}
+}
+
+SharedData<uint8_t> RamStorageMedia::readFromMedia (const unsigned int sizeInBytes, const unsigned int offsetInBytes)
+{
+	std::lock_guard<std::mutex> guard( m_Mutex );
+
+	this->simulateAccessTime( sizeInBytes );
+
+	m_NumReads++;
+	m_NumBytesRead += sizeInBytes;
+
+	// anything past the end of the media reads as zeroes
+	SharedData<uint8_t> data = SharedData<uint8_t>::MakeSharedData( sizeInBytes );
+	if ( sizeInBytes == 0 ) return data;
+
+	memset( &data[0], 0, sizeInBytes );
+	if ( offsetInBytes < m_Data.size() )
+	{
+		const size_t numBytesToRead = std::min<size_t>( sizeInBytes, m_Data.size() - offsetInBytes );
+		memcpy( &data[0], &m_Data[offsetInBytes], numBytesToRead );
+	}
+
+	return data;
+}
+
+bool RamStorageMedia::formatFat16 (unsigned int numSectorsPerCluster)
+{
+	if ( numSectorsPerCluster == 0 || numSectorsPerCluster > 128 ) return false;
+
+	const unsigned int numSectors = static_cast<unsigned int>( m_Data.size() / RAM_MEDIA_SECTOR_SIZE );
+	const unsigned int numRootDirectorySectors = ( RAM_MEDIA_NUM_ROOT_ENTRIES * 32 ) / RAM_MEDIA_SECTOR_SIZE;
+
+	// the FAT needs to be big enough for every cluster in what's left after it
+	unsigned int numSectorsPerFat = 1;
+	unsigned int numClusters = 0;
+	while ( true )
+	{
+		const unsigned int numMetadataSectors = RAM_MEDIA_NUM_RESERVED_SECTORS + ( RAM_MEDIA_NUM_FATS * numSectorsPerFat )
+							+ numRootDirectorySectors;
+		if ( numMetadataSectors >= numSectors ) return false;
+
+		numClusters = ( numSectors - numMetadataSectors ) / numSectorsPerCluster;
+		if ( (numClusters + 2) * 2 <= numSectorsPerFat * RAM_MEDIA_SECTOR_SIZE ) break;
+
+		numSectorsPerFat++;
+	}
+
+	if ( numClusters < RAM_MEDIA_MIN_FAT16_CLUSTERS || numClusters > RAM_MEDIA_MAX_FAT16_CLUSTERS ) return false;
+
+	std::lock_guard<std::mutex> guard( m_Mutex );
+
+	const unsigned int numMetadataBytes = ( RAM_MEDIA_NUM_RESERVED_SECTORS + (RAM_MEDIA_NUM_FATS * numSectorsPerFat)
+						+ numRootDirectorySectors ) * RAM_MEDIA_SECTOR_SIZE;
+	memset( m_Data.data(), 0, numMetadataBytes );
+
+	uint8_t* bootSector = m_Data.data();
+	bootSector[BOOT_SEC_JUMP_OFFSET] = 0xEB;
+	bootSector[BOOT_SEC_JUMP_OFFSET + 1] = 0x3C;
+	bootSector[BOOT_SEC_JUMP_OFFSET + 2] = 0x90;
+	memcpy( &bootSector[BOOT_SEC_OEM_NAME_OFFSET], "MSWIN4.1", BOOT_SEC_OEM_NAME_SIZE );
+	writeLittleEndian( &bootSector[BOOT_SEC_SECTOR_SIZE_OFFSET], RAM_MEDIA_SECTOR_SIZE, BOOT_SEC_SECTOR_SIZE_SIZE );
+	writeLittleEndian( &bootSector[BOOT_SEC_NUM_SECS_PER_CLUSTER_OFFSET], numSectorsPerCluster, BOOT_SEC_NUM_SECS_PER_CLUSTER_SIZE );
+	writeLittleEndian( &bootSector[BOOT_SEC_RESERVED_SECS_OFFSET], RAM_MEDIA_NUM_RESERVED_SECTORS, BOOT_SEC_RESERVED_SECS_SIZE );
+	writeLittleEndian( &bootSector[BOOT_SEC_NUM_FATS_OFFSET], RAM_MEDIA_NUM_FATS, BOOT_SEC_NUM_FATS_SIZE );
+	writeLittleEndian( &bootSector[BOOT_SEC_NUM_DIRS_IN_ROOT_OFFSET], RAM_MEDIA_NUM_ROOT_ENTRIES, BOOT_SEC_NUM_DIRS_IN_ROOT_SIZE );
+	if ( numSectors < 65536 )
+	{
+		writeLittleEndian( &bootSector[BOOT_SEC_NUM_SECS_ON_DISK_LT_32MB_OFFSET], numSectors, BOOT_SEC_NUM_SECS_ON_DISK_LT_32MB_SIZE );
+	}
+	else
+	{
+		writeLittleEndian( &bootSector[BOOT_SEC_NUM_SECS_ON_DISK_GT_32MB_OFFSET], numSectors, BOOT_SEC_NUM_SECS_ON_DISK_GT_32MB_SIZE );
+	}
+	bootSector[BOOT_SEC_MEDIA_DESCRIPTOR_OFFSET] = 0xF8;
+	writeLittleEndian( &bootSector[BOOT_SEC_NUM_SECS_PER_FAT_OFFSET], numSectorsPerFat, BOOT_SEC_NUM_SECS_PER_FAT_SIZE );
+	bootSector[BOOT_SEC_DRIVE_NUMBER_FAT16_OFFSET] = 0x80;
+	bootSector[BOOT_SEC_BOOT_SIGNATURE_FAT16_OFFSET] = 0x29;
+	memcpy( &bootSector[BOOT_SEC_VOLUME_LABEL_FAT16_OFFSET], "NO NAME    ", BOOT_SEC_VOLUME_LABEL_SIZE );
+	memcpy( &bootSector[BOOT_SEC_FILE_SYS_TYPE_FAT16_OFFSET], "FAT16   ", BOOT_SEC_FILE_SYS_TYPE_SIZE );
+	bootSector[BOOT_SEC_BOOT_SECTOR_SIGNATURE_OFFSET] = 0x55;
+	bootSector[BOOT_SEC_BOOT_SECTOR_SIGNATURE_OFFSET + 1] = 0xAA;
+
+	// the first two FAT entries hold the media descriptor and the end of chain marker
+	for ( unsigned int fat = 0; fat < RAM_MEDIA_NUM_FATS; fat++ )
+	{
+		uint8_t* fatData = &m_Data[( RAM_MEDIA_NUM_RESERVED_SECTORS + (fat * numSectorsPerFat) ) * RAM_MEDIA_SECTOR_SIZE];
+		writeLittleEndian( &fatData[0], 0xFFF8, 2 );
+		writeLittleEndian( &fatData[2], 0xFFFF, 2 );
+	}
+
+	return true;
+}
+
+void RamStorageMedia::setLatency (unsigned int latencyInMicroseconds, unsigned int bandwidthInKBPerSecond)
+{
+	std::lock_guard<std::mutex> guard( m_Mutex );
+
+	m_LatencyInMicroseconds = latencyInMicroseconds;
+	m_BandwidthInKBPerSecond = bandwidthInKBPerSecond;
+}
+
+void RamStorageMedia::resetCounts()
+{
+	std::lock_guard<std::mutex> guard( m_Mutex );
+
+	m_NumReads = 0;
+	m_NumWrites = 0;
+	m_NumBytesRead = 0;
+	m_NumBytesWritten = 0;
+}
+
+void RamStorageMedia::simulateAccessTime (unsigned int sizeInBytes) const
+{
+	uint64_t accessTimeInMicroseconds = m_LatencyInMicroseconds;
+	if ( m_BandwidthInKBPerSecond > 0 )
+	{
+		accessTimeInMicroseconds += ( static_cast<uint64_t>(sizeInBytes) * 1000000 ) / ( static_cast<uint64_t>(m_BandwidthInKBPerSecond) * 1024 );
+	}
+
+	if ( accessTimeInMicroseconds == 0 ) return;
+
+	const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now()
+								+ std::chrono::microseconds( accessTimeInMicroseconds );
+	while ( std::chrono::steady_clock::now() < endTime )
+	{
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef RAMSTORAGEMEDIA_HPP
+#define RAMSTORAGEMEDIA_HPP
+
+/**************************************************************************
+ * The RamStorageMedia class defines an IStorageMedia held entirely in
+ * memory, so the file managers can be benchmarked and tested on a plain
+ * Linux box. It can be formatted as an empty FAT16 volume with no MBR.
+ * To make results from slow media reproducible, each read and write
+ * can be made to take a fixed latency plus however long the transfer
+ * takes at a given bandwidth. The delay is spun rather than slept, since
+ * sleeping is far coarser than the latencies of an SD card. Accesses
+ * are counted, and are safe to make from more than one thread.
+**************************************************************************/
+
+#include "IStorageMedia.hpp"
+
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+class RamStorageMedia : public IStorageMedia
+{
+	public:
+		// a bandwidth of 0 means transfers take no time beyond the latency
+		RamStorageMedia (unsigned int sizeInBytes, unsigned int latencyInMicroseconds = 0, unsigned int bandwidthInKBPerSecond = 0);
+
+		void writeToMedia (const SharedData<uint8_t>& data, const unsigned int offsetInBytes) override;
+		SharedData<uint8_t> readFromMedia (const unsigned int sizeInBytes, const unsigned int offsetInBytes) override;
+		bool hasMBR() override { return false; }
+
+		// Lays an empty FAT16 volume over the whole media, with 512 byte sectors, two FATs and a 512 entry root directory.
+		// Returns false if the media is too small or too big for a FAT16 volume with that many sectors per cluster
+		bool formatFat16 (unsigned int numSectorsPerCluster);
+
+		void setLatency (unsigned int latencyInMicroseconds, unsigned int bandwidthInKBPerSecond);
+
+		unsigned int getSizeInBytes() const { return static_cast<unsigned int>( m_Data.size() ); }
+		// the media itself, for checking what was written without going through a file manager
+		const uint8_t* getData() const { return m_Data.data(); }
+
+		unsigned int getNumReads() const { return m_NumReads; }
+		unsigned int getNumWrites() const { return m_NumWrites; }
+		uint64_t getNumBytesRead() const { return m_NumBytesRead; }
+		uint64_t getNumBytesWritten() const { return m_NumBytesWritten; }
+		void resetCounts();
+
+	private:
+		std::vector<uint8_t> 	m_Data;
+		unsigned int 		m_LatencyInMicroseconds;
+		unsigned int 		m_BandwidthInKBPerSecond;
+		std::mutex 		m_Mutex;
+
+		unsigned int 		m_NumReads;
+		unsigned int 		m_NumWrites;
+		uint64_t 		m_NumBytesRead;
+		uint64_t 		m_NumBytesWritten;
+
+		void simulateAccessTime (unsigned int sizeInBytes) const;
+};
+
+#endif // RAMSTORAGEMEDIA_HPP
@@ -86,6 +86,7 @@ class BootSector
 		~BootSector();
 
 		PartitionType getPartitionType() const;
+		bool isFat32() const;
 
 		bool volumeIdLabelAndFSTypeAreValid() const;
 
@@ -100,7 +101,7 @@ class BootSector
 		uint16_t 	getNumDirectoryEntriesInRoot() const;
 		uint32_t 	getNumSectorsOnDisk() const;
 		uint8_t 	getMediaDescriptor() const;
-		uint16_t 	getNumSectorsPerFat() const;
+		uint32_t 	getNumSectorsPerFat() const; // FAT32 needs all 32 bits
 		uint16_t 	getNumSectorsPerTrack() const;
 		uint16_t 	getNumHeads() const;
 		uint32_t 	getNumHiddenSectors() const;
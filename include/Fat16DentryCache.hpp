@@ -0,0 +1,51 @@
+#ifndef FAT16DENTRYCACHE_HPP
+#define FAT16DENTRYCACHE_HPP
+
+/**************************************************************************
+ * The Fat16DentryCache class defines a small, bounded cache of directory
+ * entries that were recently resolved by name. Each cached entry is keyed
+ * on the starting cluster of the directory it lives in (0 for the root
+ * directory) and its raw 8.3 name. When the cache is full the least
+ * recently used entry is replaced.
+**************************************************************************/
+
+#include "Fat16Entry.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+#define FAT16_DENTRY_CACHE_DEFAULT_SIZE 32
+
+struct Fat16Dentry
+{
+	bool 		isValid;
+	uint32_t 	dirCluster;
+	uint32_t 	lastUsed;
+	uint8_t 	entryData[FAT16_ENTRY_SIZE];
+};
+
+class Fat16DentryCache
+{
+	public:
+		Fat16DentryCache (unsigned int numDentries = FAT16_DENTRY_CACHE_DEFAULT_SIZE);
+		~Fat16DentryCache();
+
+		// resizing drops every cached entry
+		void setNumDentries (unsigned int numDentries);
+		unsigned int getNumDentries() const { return m_Dentries.size(); }
+
+		// returns the raw entry data, or nullptr if the entry isn't cached
+		const uint8_t* find (uint32_t dirCluster, const char* filenameRaw, const char* extensionRaw);
+
+		void insert (uint32_t dirCluster, const uint8_t* entryData);
+		void remove (uint32_t dirCluster, const char* filenameRaw, const char* extensionRaw);
+		void clear();
+
+	private:
+		std::vector<Fat16Dentry> 	m_Dentries;
+		uint32_t 			m_UseCounter;
+
+		Fat16Dentry* findDentry (uint32_t dirCluster, const char* filenameRaw, const char* extensionRaw);
+};
+
+#endif // FAT16DENTRYCACHE_HPP
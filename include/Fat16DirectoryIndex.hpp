@@ -0,0 +1,51 @@
+#ifndef FAT16DIRECTORYINDEX_HPP
+#define FAT16DIRECTORYINDEX_HPP
+
+/**************************************************************************
+ * The Fat16DirectoryIndex class defines an open addressing hash table
+ * that maps the raw 8.3 names of the entries in a directory to their
+ * entry numbers, so that an entry can be found by name without scanning
+ * the whole directory. Each slot only holds an entry number and a 32 bit
+ * hash of the name, the names themselves are compared against the raw
+ * directory data. The table can grow to twice the most entries a
+ * directory can have, so every entry of even the biggest directory is
+ * indexed.
+**************************************************************************/
+
+#include "Fat16Entry.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+#define FAT16_DIRECTORY_INDEX_NOT_FOUND 0xFFFFFFFF
+
+class Fat16DirectoryIndex
+{
+	public:
+		Fat16DirectoryIndex();
+		~Fat16DirectoryIndex();
+
+		// clears the index and adds every used entry in the raw directory data to it
+		void build (const uint8_t* directoryData, unsigned int numEntries);
+		void clear();
+
+		// unused and deleted entries are ignored
+		void insert (const uint8_t* entryData, unsigned int entryNum);
+		void remove (const uint8_t* entryData, unsigned int entryNum);
+
+		// filename and extension must be the raw, space padded names. Returns FAT16_DIRECTORY_INDEX_NOT_FOUND if no entry matches
+		unsigned int find (const char* filenameRaw, const char* extensionRaw, const uint8_t* directoryData, unsigned int numEntries) const;
+
+	private:
+		std::vector<uint64_t> 	m_Slots; // hash in the upper 32 bits, entry number in the lower 32 bits
+		unsigned int 		m_NumUsedSlots; // including removed slots, since they still lengthen probe sequences
+		unsigned int 		m_NumEntries;
+
+		static uint32_t hashName (const char* filenameRaw, const char* extensionRaw);
+		static bool namesMatch (const uint8_t* entryData, const char* filenameRaw, const char* extensionRaw);
+
+		void insertSlot (uint64_t slotVal);
+		void rehash (unsigned int minNumEntries);
+};
+
+#endif // FAT16DIRECTORYINDEX_HPP
@@ -0,0 +1,76 @@
+#ifndef FAT16DIRECTORYVIEW_HPP
+#define FAT16DIRECTORYVIEW_HPP
+
+/**************************************************************************
+ * The Fat16DirectoryView class defines a lightweight listing of a
+ * directory. The raw directory entries are kept in the single buffer
+ * they were read into, and each entry is decoded lazily through a
+ * non-owning Fat16EntryView, so listing a directory doesn't allocate
+ * an object per entry. A view can optionally skip the unused and
+ * deleted slots of a directory.
+**************************************************************************/
+
+#include "Fat16Entry.hpp"
+#include "SharedData.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+class Fat16EntryView
+{
+	public:
+		// the upper 16 bits of the starting cluster are only read if hasStartingClusterNumHigh is set, since FAT16 uses that
+		// field for other things
+		Fat16EntryView (const uint8_t* entryData, bool hasStartingClusterNumHigh = false) :
+			m_EntryData( entryData ),
+			m_HasStartingClusterNumHigh( hasStartingClusterNumHigh ) {}
+
+		// copies the entry out into a full Fat16Entry (on the stack, so no allocation)
+		Fat16Entry toEntry() const { return Fat16Entry( m_EntryData ); }
+
+		const uint8_t* getUnderlyingData() const { return m_EntryData; }
+
+		// these are not null terminated, and can contain special characters
+		const char* getFilenameRaw() const { return reinterpret_cast<const char*>( &m_EntryData[FAT16_FILENAME_OFFSET] ); }
+		const char* getExtensionRaw() const { return reinterpret_cast<const char*>( &m_EntryData[FAT16_EXTENSION_OFFSET] ); }
+
+		// displayName needs to hold at least FAT16_FILENAME_SIZE + FAT16_EXTENSION_SIZE + 2 characters
+		void getFilenameDisplay (char* displayName) const;
+
+		uint8_t getFileAttributesRaw() const { return m_EntryData[FAT16_ATTRIBUTES_OFFSET]; }
+		uint32_t getStartingClusterNum() const;
+		uint32_t getFileSizeInBytes() const;
+
+		bool isUnusedEntry() const { return m_EntryData[FAT16_FILENAME_OFFSET] == 0x00; }
+		bool isDeletedEntry() const { return m_EntryData[FAT16_FILENAME_OFFSET] == 0xE5; }
+		bool isSubdirectory() const { return this->getFileAttributesRaw() & 0x10; }
+
+	private:
+		const uint8_t* 	m_EntryData;
+		bool 		m_HasStartingClusterNumHigh;
+};
+
+class Fat16DirectoryView
+{
+	public:
+		// hasStartingClusterNumHigh is passed on to each entry view, and is set for FAT32 directories
+		Fat16DirectoryView (const SharedData<uint8_t>& directoryData, bool skipUnusedAndDeletedEntries = false,
+					bool hasStartingClusterNumHigh = false);
+		~Fat16DirectoryView();
+
+		unsigned int getNumEntries() const;
+		Fat16EntryView getEntry (unsigned int viewEntryNum) const;
+
+		// the entry number within the directory, for use with selectEntry and deleteEntry
+		unsigned int getDirectoryEntryNum (unsigned int viewEntryNum) const;
+
+	private:
+		SharedData<uint8_t> 	m_DirectoryData;
+		const uint8_t* 		m_DirectoryDataPtr;
+		unsigned int 		m_NumDirectoryEntries;
+		bool 			m_SkipUnusedAndDeletedEntries;
+		bool 			m_HasStartingClusterNumHigh;
+		std::vector<uint16_t> 	m_UsedEntryNums;
+};
+
+#endif // FAT16DIRECTORYVIEW_HPP
@@ -4,13 +4,12 @@
 /**************************************************************************
  * The Fat16Entry class defines a directory entry for a FAT16 file
  * system. It provides functions for determining what type of entry
- * it is and also acts as a 'handle' to fat16 files. You can use these
- * handles to initiate file read or write sequences.
+ * it is. To read or write the file an entry refers to, open a
+ * Fat16FileHandle on it through the Fat16FileManager.
 **************************************************************************/
 
 #include <stdint.h>
 #include <string>
-#include <vector>
 
 // FAT16 entry offsets and sizes
 #define FAT16_ENTRY_SIZE 			32
@@ -20,6 +19,8 @@
 #define FAT16_EXTENSION_SIZE 			3
 #define FAT16_ATTRIBUTES_OFFSET 		0x0B
 #define FAT16_ATTRIBUTES_SIZE 			1
+#define FAT16_STARTING_CLUSTER_NUM_HIGH_OFFSET 	0x14 // FAT32 only, the upper 16 bits of the starting cluster
+#define FAT16_STARTING_CLUSTER_NUM_HIGH_SIZE 	2
 #define FAT16_TIME_LAST_UPDATED_OFFSET 		0x16
 #define FAT16_TIME_LAST_UPDATED_SIZE 		2
 #define FAT16_DATE_LAST_UPDATED_OFFSET 		0x18
@@ -47,24 +48,17 @@ struct Fat16Date
 	uint8_t day;
 };
 
-struct Fat16ClusterMod
-{
-	uint16_t clusterNum;
-	uint16_t clusterNewVal;
-};
-
 class Fat16Entry
 {
 	public:
-		Fat16Entry (uint8_t* offset);
+		Fat16Entry (const uint8_t* offset);
 		Fat16Entry (const std::string& filename, const std::string& extension);
-		Fat16Entry (const Fat16Entry& other);
-		void operator= (const Fat16Entry& other);
-		~Fat16Entry();
 
 		void setToDeleted();
 
 		void setStartingClusterNum (uint16_t clusterNum);
+		// FAT32 entries use the same layout, with the upper 16 bits of the starting cluster in a field FAT16 leaves as zero
+		void setStartingClusterNumHigh (uint16_t clusterNumHigh);
 		void setFileSizeInBytes (uint32_t fileSize);
 
 		const uint8_t* getUnderlyingData() const;
@@ -84,6 +78,7 @@ class Fat16Entry
 		const Fat16Date getDateUpdated() const;
 
 		uint16_t getStartingClusterNum() const;
+		uint16_t getStartingClusterNumHigh() const;
 
 		uint32_t getFileSizeInBytes() const;
 
@@ -100,36 +95,13 @@ class Fat16Entry
 
 		bool isInvalidEntry() const;
 
-		bool& getFileTransferInProgressFlagRef() { return m_FileTransferInProgress; }
-		unsigned int& getCurrentFileSectorRef() { return m_CurrentFileSector; }
-		unsigned int& getCurrentFileClusterRef() { return m_CurrentFileCluster; }
-		unsigned int& getCurrentDirOffsetRef() { return m_CurrentDirOffset; }
-		unsigned int& getCurrentFileOffsetRef() { return m_CurrentFileOffset; }
-		unsigned int& getNumBytesReadRef() { return m_NumBytesRead; }
-		std::vector<Fat16ClusterMod>& getClustersToModifyRef() { return m_ClustersToModify; }
-
 	private:
+		// every field is decoded from the underlying data when asked for, so entries are trivially copyable
 		uint8_t 	m_UnderlyingData[FAT16_ENTRY_SIZE];
-		char 		m_Filename[FAT16_FILENAME_SIZE];
-		char 		m_Extension[FAT16_EXTENSION_SIZE];
 		char 		m_FilenameWithExtension[FAT16_FILENAME_SIZE + FAT16_EXTENSION_SIZE + 2]; // plus 2 for . and string terminator
-		uint8_t 	m_FileAttributes;
-		uint16_t 	m_TimeLastUpdated;
-		uint16_t 	m_DateLastUpdated;
-		uint16_t 	m_StartingClusterNum;
-		uint32_t 	m_FileSizeInBytes;
 
 		bool 		m_IsInvalidEntry;
 
-		bool 		m_FileTransferInProgress;
-		unsigned int 	m_CurrentFileSector;
-		unsigned int 	m_CurrentFileCluster;
-		unsigned int 	m_CurrentDirOffset;
-		unsigned int 	m_CurrentFileOffset;
-		unsigned int 	m_NumBytesRead = 0;
-
-		std::vector<Fat16ClusterMod> 	m_ClustersToModify;
-
 		void createFilenameDisplayString();
 		void createFilenameDisplayStringHelper (unsigned int startCharacter);
 };
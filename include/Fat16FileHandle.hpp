@@ -0,0 +1,95 @@
+#ifndef FAT16FILEHANDLE_HPP
+#define FAT16FILEHANDLE_HPP
+
+/**************************************************************************
+ * The Fat16FileHandle class holds the state of a single read or write
+ * of a FAT16 file: the cursor into the cluster chain and, for writes,
+ * the clusters reserved so far (after the rest of the chain, for a
+ * write over an existing file). It keeps its own copy of the entry it
+ * was opened on, so any number of handles can read the same entry at
+ * once. Handles can be moved but not copied, since only one handle may
+ * own a set of reserved clusters. Handles are opened and driven through
+ * the Fat16FileManager (or the Fat32FileManager, which shares the same
+ * handles), and must not outlive it.
+**************************************************************************/
+
+#include <stdint.h>
+#include <vector>
+
+#include "Fat16Entry.hpp"
+#include "SharedData.hpp"
+
+// every this many clusters in a file's chain, the cluster number is kept in the handle's skip index for seeking
+#define FAT16_CLUSTER_SKIP_INTERVAL 	16
+// the directory entry number of a handle writing a new file, which takes an unused entry when it is finalized
+#define FAT16_NEW_DIRECTORY_ENTRY 	0xFFFFFFFF
+
+class IFatFileManager;
+class Fat16ReadAhead;
+template <typename Traits> class FatFileManager;
+
+struct Fat16ClusterMod
+{
+	uint32_t clusterNum;
+	uint32_t clusterNewVal;
+};
+
+class Fat16FileHandle
+{
+	public:
+		Fat16FileHandle();
+		Fat16FileHandle (Fat16FileHandle&& other);
+		Fat16FileHandle& operator= (Fat16FileHandle&& other);
+		Fat16FileHandle (const Fat16FileHandle& other) = delete;
+		void operator= (const Fat16FileHandle& other) = delete;
+		~Fat16FileHandle();
+
+		// ends any read or write in progress, a write that wasn't finalized gives its reserved clusters back
+		void close();
+
+		bool isFileTransferInProgress() const { return m_FileTransferInProgress; }
+		// set when a read of the file couldn't be read from the storage media, which ends the read rather than skipping the data.
+		// Cleared when the handle is seeked, reopened or closed
+		bool hasReadError() const { return m_HasReadError; }
+
+		// for a write this is updated with the starting cluster and size as the file is written
+		const Fat16Entry& getEntry() const { return m_Entry; }
+
+	private:
+		template <typename Traits> friend class FatFileManager;
+
+		IFatFileManager* 		m_FileManager;
+		Fat16Entry 			m_Entry;
+
+		bool 				m_FileTransferInProgress;
+		bool 				m_HasReadError;
+		unsigned int 			m_CurrentFileSector;
+		unsigned int 			m_CurrentFileCluster;
+		unsigned int 			m_CurrentDirOffset;
+		unsigned int 			m_CurrentFileOffset;
+		unsigned int 			m_NumBytesRead;
+
+		std::vector<Fat16ClusterMod> 	m_ClustersToModify;
+		// where the cursor's cluster is in m_ClustersToModify, which may go on past it if clusters were reserved up front
+		unsigned int 			m_CurrentClusterModIndex;
+		// when writing over an existing file, m_ClustersToModify starts with the rest of its chain, which is never given back
+		unsigned int 			m_NumExistingClusterMods;
+		unsigned int 			m_FirstClusterModNumInChain; // how far into the file's chain m_ClustersToModify starts
+		unsigned int 			m_DirectoryEntryNum; // FAT16_NEW_DIRECTORY_ENTRY unless writing over an existing file
+		uint32_t 			m_WritePosition; // the byte offset in the file the next write starts at
+		// a write of less than a sector is padded out in here, so writers on different handles don't share a buffer. For reads,
+		// it holds what is left of the last sector read() only took part of
+		SharedData<uint8_t> 		m_SectorBuffer;
+		unsigned int 			m_NumBytesInSectorBuffer;
+		uint32_t 			m_ReadPosition; // the byte offset read() carries on from
+
+		// built lazily as reads seek further into the file, entry n is the cluster at n * FAT16_CLUSTER_SKIP_INTERVAL
+		std::vector<uint32_t> 		m_ClusterSkipIndex;
+
+		// only set while read ahead is turned on for the handle, and kept when the handle is closed or reopened
+		Fat16ReadAhead* 		m_ReadAhead;
+
+		void moveFrom (Fat16FileHandle& other);
+};
+
+#endif // FAT16FILEHANDLE_HPP
@@ -0,0 +1,59 @@
+#ifndef FAT16READAHEAD_HPP
+#define FAT16READAHEAD_HPP
+
+/**************************************************************************
+ * The Fat16ReadAhead class is a ring of windows read ahead of where a
+ * file handle is being read from. Each window is a run of up to a set
+ * number of sectors, read through its own FatAsyncRequest, so with an
+ * async storage media several windows can be in flight while the
+ * consumer works through the oldest one. Read ahead only starts once a
+ * handle has been read sequentially a few times since it was opened or
+ * last seeked, so random access isn't slowed by reads that go unused.
+**************************************************************************/
+
+#include <stdint.h>
+
+#include "FatAsyncRequest.hpp"
+
+#define FAT16_READ_AHEAD_MIN_SEQUENTIAL_READS 	2
+
+class Fat16ReadAhead
+{
+	public:
+		Fat16ReadAhead (unsigned int windowSizeInSectors, unsigned int depth);
+		Fat16ReadAhead (const Fat16ReadAhead& other) = delete;
+		void operator= (const Fat16ReadAhead& other) = delete;
+		// waits for any windows still in flight, since the storage media holds on to their requests
+		~Fat16ReadAhead();
+
+		unsigned int getWindowSizeInSectors() const { return m_WindowSizeInSectors; }
+		unsigned int getDepth() const { return m_Depth; }
+
+		bool isEmpty() const { return m_NumWindows == 0; }
+		bool isFull() const { return m_NumWindows == m_Depth; }
+
+		// counts a read of the handle, returns true once enough reads in a row have been made to start reading ahead
+		bool countSequentialRead();
+
+		// the request for a new window at the tail of the ring, only call if not full
+		FatAsyncRequest& pushWindow();
+		// the data of the oldest window, waiting for it to be read if it is still in flight
+		const SharedData<uint8_t>& waitForHeadWindow();
+		unsigned int getHeadOffset() const { return m_HeadOffset; }
+		// moves through the oldest window, dropping it once all of it has been consumed
+		void consumeHeadWindow (unsigned int numBytes);
+
+		// waits for and drops every window, and starts counting sequential reads again
+		void clear();
+
+	private:
+		unsigned int 		m_WindowSizeInSectors;
+		unsigned int 		m_Depth;
+		FatAsyncRequest* 	m_Windows;
+		unsigned int 		m_HeadWindow;
+		unsigned int 		m_NumWindows;
+		unsigned int 		m_HeadOffset;
+		unsigned int 		m_NumSequentialReads;
+};
+
+#endif // FAT16READAHEAD_HPP
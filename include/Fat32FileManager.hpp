@@ -0,0 +1,23 @@
+#ifndef FAT32FILEMANAGER_HPP
+#define FAT32FILEMANAGER_HPP
+
+/**************************************************************************
+ * The Fat32FileManager defines a tool for navigating through a FAT32
+ * file system and retrieving and writing data. It is the FatFileManager
+ * compiled for 32 bit FAT entries, so it has the same functions as the
+ * Fat16FileManager. The root directory is a cluster chain and grows like
+ * any other directory. Storage media offsets are 32 bits, so the volume
+ * is treated as ending with the last cluster that ends within the first
+ * 4GB of the storage media, for reading and writing alike, and the free
+ * cluster count in its FSInfo sector is left unknown. A volume whose
+ * root directory isn't within those clusters isn't mounted. By default
+ * the FAT is paged in and out of a small cache rather than held in
+ * memory whole, and with an allocator only the first FAT_BITMAP_MAX_BITS
+ * clusters are handed out to new files.
+**************************************************************************/
+
+#include "FatFileManager.hpp"
+
+typedef FatFileManager<Fat32Traits> Fat32FileManager;
+
+#endif // FAT32FILEMANAGER_HPP
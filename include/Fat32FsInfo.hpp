@@ -0,0 +1,48 @@
+#ifndef FAT32FSINFO_HPP
+#define FAT32FSINFO_HPP
+
+/**************************************************************************
+ * The Fat32FsInfo class defines the FSInfo sector of a FAT32 file
+ * system, which caches the number of free clusters and where to start
+ * looking for the next free one. Both are only hints, and either may be
+ * unknown, so they are only trusted if the signatures are valid and the
+ * values are in range.
+**************************************************************************/
+
+#include <stdint.h>
+
+// FSInfo offsets and sizes
+#define FS_INFO_SIZE_IN_BYTES 			512
+#define FS_INFO_LEAD_SIGNATURE_OFFSET 		0x000
+#define FS_INFO_LEAD_SIGNATURE 			0x41615252
+#define FS_INFO_STRUCT_SIGNATURE_OFFSET 	0x1E4
+#define FS_INFO_STRUCT_SIGNATURE 		0x61417272
+#define FS_INFO_NUM_FREE_CLUSTERS_OFFSET 	0x1E8
+#define FS_INFO_NEXT_FREE_CLUSTER_OFFSET 	0x1EC
+#define FS_INFO_TRAIL_SIGNATURE_OFFSET 		0x1FC
+#define FS_INFO_TRAIL_SIGNATURE 		0xAA550000
+#define FS_INFO_UNKNOWN 			0xFFFFFFFF // for either the free cluster count or the next free cluster
+
+class Fat32FsInfo
+{
+	public:
+		Fat32FsInfo (const uint8_t* offset);
+
+		bool signaturesAreValid() const;
+
+		uint32_t getNumFreeClusters() const;
+		uint32_t getNextFreeCluster() const;
+
+		void setNumFreeClusters (uint32_t numFreeClusters);
+		void setNextFreeCluster (uint32_t nextFreeCluster);
+
+		const uint8_t* getUnderlyingData() const;
+
+	private:
+		uint8_t 	m_UnderlyingData[FS_INFO_SIZE_IN_BYTES];
+
+		uint32_t readUInt32 (unsigned int offset) const;
+		void writeUInt32 (unsigned int offset, uint32_t value);
+};
+
+#endif // FAT32FSINFO_HPP
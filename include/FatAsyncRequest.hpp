@@ -0,0 +1,57 @@
+#ifndef FATASYNCREQUEST_HPP
+#define FATASYNCREQUEST_HPP
+
+/**************************************************************************
+ * The FatAsyncRequest class tracks an asynchronous read or write issued
+ * through the file manager. One request may be made up of several
+ * transfers to the storage media (a write that crosses a gap in the
+ * cluster chain for example), and it only completes once all of them
+ * have. The caller can either poll isComplete(), or subclass it and
+ * override onComplete() to be called back. Completion may happen on
+ * whatever context the IAsyncStorageMedia finishes transfers on (an
+ * interrupt, another thread), or right away if the transfer is done
+ * synchronously.
+**************************************************************************/
+
+#include <stdint.h>
+#include <atomic>
+
+#include "SharedData.hpp"
+
+class FatAsyncRequest
+{
+	public:
+		FatAsyncRequest();
+		FatAsyncRequest (const FatAsyncRequest& other) = delete;
+		void operator= (const FatAsyncRequest& other) = delete;
+		virtual ~FatAsyncRequest() {}
+
+		// a request can't be reused while it is pending
+		bool isPending() const { return m_NumPendingTransfers.load() != 0; }
+		bool isComplete() const { return m_IsComplete.load(); }
+		// spins until every transfer is done, which relies on the storage media completing them from an interrupt or another thread
+		void waitForCompletion() const { while ( this->isPending() ) {} }
+
+		// the data from the last read transfer to complete, null for writes. Only valid once the request is complete
+		const SharedData<uint8_t>& getData() const { return m_Data; }
+
+		// called by the IAsyncStorageMedia once a transfer is done, with the data read or a null SharedData for a write
+		void completeTransfer (const SharedData<uint8_t>& data);
+
+		// used by the file manager when issuing the request. begin() holds the request open until end(), so that transfers
+		// completing while others are still being issued don't complete the whole request early
+		void begin();
+		void addTransfer() { m_NumPendingTransfers++; }
+		void end();
+
+	protected:
+		// called once every transfer of the request is complete, before the request stops pending
+		virtual void onComplete() {}
+
+	private:
+		std::atomic<unsigned int> 	m_NumPendingTransfers;
+		std::atomic<bool> 		m_IsComplete;
+		SharedData<uint8_t> 		m_Data;
+};
+
+#endif // FATASYNCREQUEST_HPP
@@ -0,0 +1,57 @@
+#ifndef FATBITMAP_HPP
+#define FATBITMAP_HPP
+
+/**************************************************************************
+ * The FatBitmap class defines a fixed size bitmap, used to keep track of
+ * per cluster or per sector state (free clusters, dirty sectors, etc)
+ * without rescanning the FAT. Searches are done a word at a time.
+**************************************************************************/
+
+#include <stdint.h>
+
+#define FAT_BITMAP_BITS_PER_WORD 	32
+#define FAT_BITMAP_MAX_BITS 		65536 // enough for every cluster in a FAT16 file system
+
+class IAllocator;
+
+class FatBitmap
+{
+	public:
+		FatBitmap (IAllocator* allocator = nullptr);
+		FatBitmap (const FatBitmap& other) = delete;
+		void operator= (const FatBitmap& other) = delete;
+		~FatBitmap();
+
+		// (re)allocates the bitmap and clears every bit
+		void setNumBits (unsigned int numBits);
+		unsigned int getNumBits() const { return m_NumBits; }
+
+		void setBit (unsigned int bit) { m_Words[bit / FAT_BITMAP_BITS_PER_WORD] |= ( 1u << (bit % FAT_BITMAP_BITS_PER_WORD) ); }
+		void clearBit (unsigned int bit) { m_Words[bit / FAT_BITMAP_BITS_PER_WORD] &= ~( 1u << (bit % FAT_BITMAP_BITS_PER_WORD) ); }
+		bool isBitSet (unsigned int bit) const { return m_Words[bit / FAT_BITMAP_BITS_PER_WORD] & ( 1u << (bit % FAT_BITMAP_BITS_PER_WORD) ); }
+
+		void clearAllBits();
+		// ors numBits bits, packed a word at a time like the bitmap itself, in starting at firstBit. Bits past getNumBits() are dropped
+		void setBits (unsigned int firstBit, const uint32_t* bits, unsigned int numBits);
+
+		// returns getNumBits() if there are no set bits at or after startBit
+		unsigned int findNextSetBit (unsigned int startBit) const;
+		// same as above, but ignores any bit that is also set in the excluded bitmap (which must be the same size)
+		unsigned int findNextSetBitExcluding (unsigned int startBit, const FatBitmap& excluded) const;
+		// returns the first bit of the first run of runLength bits at or after startBit that are set here and not in excluded
+		unsigned int findNextRunOfSetBitsExcluding (unsigned int startBit, unsigned int runLength, const FatBitmap& excluded) const;
+		// returns the first bit of the first of the longest runs, and its length (0 and getNumBits() if there are no such bits)
+		unsigned int findLongestRunOfSetBitsExcluding (const FatBitmap& excluded, unsigned int& runLength) const;
+
+		unsigned int countSetBits() const;
+
+	private:
+		IAllocator* 	m_Allocator;
+		uint32_t* 	m_Words;
+		unsigned int 	m_NumBits;
+		unsigned int 	m_NumWords;
+
+		void freeWords();
+};
+
+#endif // FATBITMAP_HPP
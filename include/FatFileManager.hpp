@@ -0,0 +1,319 @@
+#ifndef FATFILEMANAGER_HPP
+#define FATFILEMANAGER_HPP
+
+/**************************************************************************
+ * The FatFileManager class defines a tool for navigating through a FAT
+ * file system and retrieving and writing data. It is compiled once per
+ * FAT width from the FatTraits given (see Fat16FileManager and
+ * Fat32FileManager). FAT32 directory entries have the same layout as
+ * FAT16 ones, so both widths use Fat16Entry and Fat16FileHandle.
+**************************************************************************/
+
+#include "IFatFileManager.hpp"
+#include "FatTraits.hpp"
+#include "Fat16Entry.hpp"
+#include "Fat16FileHandle.hpp"
+#include "Fat16DirectoryIndex.hpp"
+#include "Fat16DentryCache.hpp"
+#include "Fat16DirectoryView.hpp"
+#include "FatBitmap.hpp"
+#include "FatSectorCache.hpp"
+#include "Fat16ReadAhead.hpp"
+#include "FatWriteBehindBuffer.hpp"
+#include "Fat32FsInfo.hpp"
+#include "IFatLock.hpp"
+
+#define FAT_MAX_DIRECTORY_ENTRIES 	65536 // a directory can't be bigger than 2MB
+#define FAT_FREE_SCAN_CHUNK_SIZE 	256u // FAT entries scanned for free clusters per call when building the free cluster index
+#define FAT_MEDIA_OFFSET_LIMIT 		0x100000000ull // storage media offsets are 32 bits, so nothing at or past 4GB can be reached
+
+class IAllocator;
+
+enum class FatWritePolicy
+{
+	WRITE_THROUGH, 	// FAT changes are written to the storage media as soon as an entry is deleted or finalized
+	WRITE_BACK 	// FAT changes are only written to the storage media on sync(), so a power loss before then can lose them
+};
+
+enum class FatMountPolicy
+{
+	EAGER, 	// the FAT, root directory and free cluster index are all loaded when the file manager is constructed (the free cluster
+		// index is left until the first write if a FAT32 FSInfo sector already gives the free cluster count)
+	LAZY 	// only the boot sector is read up front, everything else is loaded the first time it is needed
+};
+
+template <typename Traits>
+class FatFileManager : public IFatFileManager
+{
+	public:
+		// numFatCachePages bounds how many sectors of the FAT are held in memory at once, by default the whole FAT is held for
+		// FAT16 and Traits::DEFAULT_NUM_FAT_CACHE_PAGES sectors are paged in and out for FAT32. If the allocator can't hold that
+		// many sectors, as many as it can hold are paged in and out as needed. If instrumentation is given, it is set as with
+		// setInstrumentation() and is also told how long mounting took
+		FatFileManager (IStorageMedia& storageMedia, IAllocator* fatCacheAllocator = nullptr,
+					unsigned int numFatCachePages = Traits::DEFAULT_NUM_FAT_CACHE_PAGES, IFatInstrumentation* instrumentation = nullptr,
+					const FatMountPolicy& mountPolicy = FatMountPolicy::EAGER);
+		~FatFileManager() override;
+
+		// Returns false if the boot sector isn't valid, if the volume isn't the FAT type this file manager is compiled for (FAT12
+		// and FAT32 volumes aren't mounted as FAT16, and the other way around), or if its data region starts too far into the
+		// storage media to be reached with 32 bit offsets
+		bool isValidFatFileSystem() override;
+
+		// This function returns the 'cursor' to the root directory and repopulates the current directory entries accordingly
+		void returnToRoot();
+
+		// This function places the 'cursor' on a given directory and returns the selected entry. If a subdirectory is selected
+		// the current directory entries are updated. An entry number past the end of the current directory gives back an
+		// unused entry and leaves the 'cursor' where it is
+		Fat16Entry selectEntry (unsigned int entryNum);
+
+		// Returns false if file is already deleted or should not be able to be deleted, true if successful
+		bool deleteEntry (unsigned int entryNum);
+
+		// The order of file writing operations are createEntry/openForWrite/openForAppend -> writeToEntry(xHoweverManyTimes) -> finalizeEntry()
+		// Opens the handle for writing the given entry in the current directory, returns false if no space available. If the
+		// expected size is given, enough clusters for it are reserved up front in as few runs of adjacent clusters as can be
+		// found (one, if the volume has a long enough run free), so the file can be written and read back in long runs. The
+		// file can still be written past the expected size, and clusters it didn't get to are given back when it is finalized
+		bool createEntry (const Fat16Entry& entry, Fat16FileHandle& handle, uint32_t expectedSizeInBytes = 0);
+		// Opens the handle for writing over an existing file in the current directory, starting at the given byte offset (which
+		// can't be past the end of the file). The rest of the file's cluster chain is written over before any clusters are added
+		// to the end of it, and finalizing writes the entry back to its own slot, so the file is changed in place. If the offset
+		// is part way through a sector, the start of that sector is read and kept so it goes out ahead of the first write, which
+		// then has to fill the sector up. A flush that ends part way through a sector with more of the file after it keeps the
+		// rest of that sector. The file only grows if written past its end. Returns false if the entry isn't a writable file,
+		// the offset is past its end or a cluster is needed and there is no space. Only one handle may write a file at a time
+		bool openForWrite (unsigned int entryNum, Fat16FileHandle& handle, uint32_t offset);
+		// same as above, with the offset at the end of the file
+		bool openForAppend (unsigned int entryNum, Fat16FileHandle& handle);
+		// writes in multiples of sector sizes, returns false if data doesn't even fit into sectors or there is no more free space.
+		// Runs of physically adjacent clusters are written to the storage media with a single write each
+		bool writeToEntry (Fat16FileHandle& handle, const SharedData<uint8_t>& data);
+		// writes data less than a sector size and finalizes the entry, returns false if there is no more free space
+		bool flushToEntry (Fat16FileHandle& handle, const SharedData<uint8_t>& data);
+		// Same as writeToEntry, but the data is handed to the async storage media (if set) and the function returns without waiting
+		// for it to be written. The FAT is still updated synchronously. The request completes once every run is written, and the
+		// data must not be modified until then. Wait for it to complete before calling flushToEntry or finalizeEntry. Returns
+		// false if the request is still pending, or for the same reasons as writeToEntry
+		bool writeToEntryAsync (Fat16FileHandle& handle, const SharedData<uint8_t>& data, FatAsyncRequest& request);
+		// returns false if the handle isn't writing or there are no available entries in directory, true if successful
+		bool finalizeEntry (Fat16FileHandle& handle);
+
+		// Write behind: a time critical writer pushes into the buffer while a flush task calls drainWriteBehind, which writes
+		// what has been queued to the handle in batches of half the buffer, ending on a cluster boundary (or a smaller power of
+		// two number of sectors, if the buffer can't hold two clusters). Anything short of a batch is left for the next drain.
+		// Data stays queued until it has been written. Returns false if the buffer is smaller than a sector, or for the same
+		// reasons as writeToEntry
+		bool drainWriteBehind (Fat16FileHandle& handle, FatWriteBehindBuffer& buffer);
+		// Writes everything left in the buffer and then finalizes the entry, so the file data is always on the storage media
+		// before the FAT and directory entry that point at it. The writer must have stopped pushing by now
+		bool finalizeWriteBehind (Fat16FileHandle& handle, FatWriteBehindBuffer& buffer);
+
+		// The entry objects are only created the first time this is called after the current directory changes, prefer
+		// getCurrentDirectoryView() which reads straight from the raw directory entries without allocating per entry
+		std::vector<Fat16Entry*>& getCurrentDirectoryEntries();
+		// a view shows the directory as it was when the view was taken, entries changed after that are changed in a copy of the
+		// raw directory entries, so a view can be read from another thread without a lock
+		Fat16DirectoryView getCurrentDirectoryView (bool skipUnusedAndDeletedEntries = false);
+
+		// looks up an entry in the current directory by name through a hashed index, without scanning the directory. The
+		// filename and extension are given without padding, as for the Fat16Entry constructor. Returns false if not found
+		bool findEntry (const std::string& filename, const std::string& extension, unsigned int& entryNum);
+
+		// Resolves a path such as "LOGS/2026/DAY01.BIN" from the root directory to its entry, without moving the 'cursor'.
+		// Resolved entries are kept in a bounded LRU cache, so repeated lookups in hot directories don't read the storage
+		// media. Returns false if any part of the path doesn't exist or isn't a subdirectory where one is needed
+		bool resolvePath (const std::string& path, Fat16Entry& entry);
+		void setDentryCacheSize (unsigned int numDentries) { m_DentryCache.setNumDentries( numDentries ); }
+
+		// The order of file reading operations are readEntry -> getSelectedFileNextSector(xHoweverManyTimes)
+		// returns true if entry is readable file and the handle has been opened for reading it, false if fail. Any number of
+		// handles can read the same entry at once
+		bool readEntry (const Fat16Entry& entry, Fat16FileHandle& handle);
+		SharedData<uint8_t> getSelectedFileNextSector (Fat16FileHandle& handle);
+		// returns up to maxNumSectors sectors of the file with a single read from the storage media, following the cluster chain
+		// for as long as the next cluster is physically adjacent to the current one. Call repeatedly to stream the file in runs
+		SharedData<uint8_t> getSelectedFileNextSectors (Fat16FileHandle& handle, unsigned int maxNumSectors);
+		// Same as getSelectedFileNextSectors, but the run is read through the async storage media (if set) and the function returns
+		// without waiting for it. The cursor moves on straight away, so further runs can be queued before this one completes.
+		// Once the request completes, its data holds the run. Returns false if the request is still pending or there is
+		// nothing left to read
+		bool readNextSectorsAsync (Fat16FileHandle& handle, unsigned int maxNumSectors, FatAsyncRequest& request);
+
+		// Turns on read ahead for the handle, until it is turned off by passing 0 for either argument. Once the handle has been
+		// read from sequentially a few times, getSelectedFileNextSector(s) keeps up to depth windows of windowSizeInSectors
+		// queued ahead of the data handed out, following the cluster chain in the cached FAT. With an async storage media set
+		// the windows are read in the background, so the caller only waits if it gets ahead of the media. Seeking, reopening
+		// or closing the handle drops whatever was read ahead. Don't mix with readNextSectorsAsync on the same handle. Returns false
+		// if read ahead was turned off
+		bool setReadAhead (Fat16FileHandle& handle, unsigned int windowSizeInSectors, unsigned int depth);
+
+		// Reads up to numBytes of the file into data, carrying on from the end of the last read() (or from the offset given to
+		// seek). Any length can be asked for. Runs of adjacent clusters are read with a single read each and copied straight
+		// into data, and the rest of a sector only partly taken is kept in the handle for the next call, so no sector is read
+		// twice. Goes through read ahead if it is turned on. Returns the number of bytes read, which is only less than numBytes
+		// at the end of the file or if the storage media couldn't be read (see Fat16FileHandle::hasReadError). Use either this
+		// or the sector functions on a handle, not both
+		unsigned int read (Fat16FileHandle& handle, uint8_t* data, unsigned int numBytes);
+
+		// Moves the read cursor of the handle to the sector holding the given byte offset, following the cluster chain in the cached
+		// FAT without reading any data. The next sector returned starts at offset rounded down to a sector. Clusters the chain is
+		// walked through are kept in a sparse per handle index, so seeking around a large file doesn't rewalk the whole chain.
+		// A read handle that reached the end of the file can be seeked again. Returns false if the handle isn't reading a file
+		// or the offset is past the end of it
+		bool seek (Fat16FileHandle& handle, uint32_t offset);
+		// Gives numBytes of the file starting at the given byte offset in data (fewer if the end of the file is reached, and none
+		// if the offset is the end of the file), reading runs of adjacent clusters with a single read each. The cursor is left
+		// at the sector after the data read. Returns false, with data left null, if the seek fails or the file can't be read
+		bool readAt (Fat16FileHandle& handle, uint32_t offset, unsigned int numBytes, SharedData<uint8_t>& data);
+
+		// ends any read or write in progress on the handle, giving back the clusters reserved by a write that wasn't finalized.
+		// This is also done when the handle is destroyed
+		void closeFile (Fat16FileHandle& handle) override;
+
+		// The free space query is answered from a count kept up to date as clusters are allocated and freed, so it doesn't rescan
+		// the FAT. On FAT32 the count is taken from the FSInfo sector at mount if it is valid, and written back to it on sync(),
+		// otherwise (and always on FAT16) the FAT is scanned once, when mounting eagerly or the first time it is needed
+		unsigned int getNumFreeClusters();
+		uint64_t getFreeSpaceInBytes();
+
+		// In write back mode modified FAT sectors are only marked dirty, and are written out when sync() is called (or when they are
+		// evicted from a paged FAT cache). Either way each dirty sector is written once per FAT copy, with adjacent dirty sectors
+		// merged into a single write
+		void setFatWritePolicy (const FatWritePolicy& policy);
+		FatWritePolicy getFatWritePolicy() const { return m_FatWritePolicy; }
+		void sync();
+
+		// Writes out anything pending on the current volume and mounts the given partition's volume the same way the constructor
+		// mounted the first, with the same number of FAT cache pages and mount policy. Files should be closed beforehand
+		void changePartition (unsigned int partitionNum) override;
+
+		// Makes the file manager safe to use from more than one thread, each lock may be null to leave that part unlocked. Reads on
+		// different handles run in parallel, only holding the FAT lock while following cluster chains (shared once the whole FAT
+		// is in memory, since a paged FAT cache changes on every lookup). The directory lock guards the current directory and the
+		// dentry cache, so browsing doesn't hold up readers. Writers only hold the FAT lock while reserving or committing clusters
+		// and the directory lock while updating directory entries, writing file data with no lock held. The directory lock is
+		// always taken before the FAT lock, and the I/O stats lock is only held while the stats are updated. Each handle must
+		// only be used by one thread at a time, the storage media must allow concurrent accesses, and the vector returned by
+		// getCurrentDirectoryEntries() is only safe to use while nothing else changes the current directory
+		void setLocks (IFatLock* fatLock, IFatLock* directoryLock, IFatLock* ioStatsLock);
+
+	private:
+		IAllocator* 			m_Allocator;
+		unsigned int 			m_NumFatCachePages;
+		FatMountPolicy 			m_MountPolicy;
+		unsigned int 			m_FatOffset;
+		FatSectorCache 			m_FatCache;
+		unsigned int 			m_RootDirectoryOffset;
+		uint32_t 			m_RootDirectoryCluster; // 0 when the root directory is a fixed region
+		unsigned int 			m_DataOffset;
+		unsigned int 			m_CurrentDirOffset;
+		SharedData<uint8_t> 		m_CurrentDirectoryData;
+		bool 				m_CurrentDirectoryIsLoaded;
+		bool 				m_CurrentDirectoryDataIsShared; // with a directory view, so it is copied before it is changed
+		std::vector<uint32_t> 		m_CurrentDirectoryClusters; // empty for a fixed root directory
+		unsigned int 			m_NumCurrentDirectoryEntries;
+		std::vector<Fat16Entry*> 	m_CurrentDirectoryEntries;
+		Fat16DirectoryIndex 		m_CurrentDirectoryIndex;
+		Fat16DentryCache 		m_DentryCache;
+
+		bool 				m_IsMounted;
+		unsigned int 			m_NumClusters; // including the two reserved clusters, and only those that can be reached
+		bool 				m_ClustersAreUnreachable; // the volume goes past what 32 bit storage media offsets can reach
+		bool 				m_FreeClusterIndexIsBuilt;
+		FatBitmap 			m_FreeClusters; // clusters that are free in the FAT, even if reserved by a pending write
+		unsigned int 			m_NumFreeClusters; // includes clusters past the end of an index bounded by an allocator
+		bool 				m_NumFreeClustersIsKnown;
+		unsigned int 			m_NextFreeClusterHint;
+
+		Fat32FsInfo* 			m_FsInfo; // only set if the file system has a valid FSInfo sector
+		unsigned int 			m_FsInfoOffset;
+
+		FatWritePolicy 			m_FatWritePolicy;
+
+		FatBitmap 			m_PendingClustersToModify;
+
+		IFatLock* 			m_FatLock;
+		IFatLock* 			m_DirectoryLock;
+
+		// request is nullptr for a synchronous write. Only the last write to a file can end part way through a sector, and the
+		// entry is left for the caller to finalize
+		bool writeToEntry (Fat16FileHandle& handle, const SharedData<uint8_t>& data, bool allowPartialSector, FatAsyncRequest* request);
+
+		void writeRunToStorageMedia (Fat16FileHandle& handle, const SharedData<uint8_t>& data, unsigned int dataOffset, unsigned int numBytes,
+						unsigned int mediaOffset, FatAsyncRequest* request);
+		// puts the start of the sector kept by openForWrite ahead of the data and, if keepTail is set, fills the rest of the last
+		// sector out with what the file already has there
+		SharedData<uint8_t> mergeWithPartialSectors (Fat16FileHandle& handle, const SharedData<uint8_t>& data, bool keepTail);
+
+		SharedData<uint8_t> readNextRun (Fat16FileHandle& handle, unsigned int maxNumSectors);
+		SharedData<uint8_t> readThroughReadAhead (Fat16FileHandle& handle, unsigned int maxNumSectors);
+		// ends the read and flags the handle, so the data that couldn't be read isn't mistaken for the end of the file
+		void failRead (Fat16FileHandle& handle);
+		// queues windows until the handle's read ahead is full or the end of the file is reached
+		void fillReadAhead (Fat16FileHandle& handle);
+		// ends the transfer without touching the handle's read ahead, which may still hold the rest of the file
+		void endFileTransfer (Fat16FileHandle& handle);
+
+		// moves the read cursor past the next run of adjacent sectors and gives where the run is, returns false if nothing is left
+		bool takeNextRun (Fat16FileHandle& handle, unsigned int maxNumSectors, unsigned int& runOffset, unsigned int& runSizeInBytes);
+
+		static bool isReadableFile (const Fat16Entry& entry);
+
+		// a FAT lookup that may load or evict a sector of a paged FAT cache needs the FAT lock to itself
+		void upgradeFatLockIfNotResident (FatLockGuard& fatGuard);
+		uint32_t getNextClusterInChain (uint32_t cluster);
+		// same as above, for when the FAT lock isn't already held
+		uint32_t lockAndGetNextClusterInChain (uint32_t cluster);
+		// finds the cluster at the given position in the file's chain, using and extending the handle's skip index
+		bool findClusterInChain (Fat16FileHandle& handle, unsigned int clusterIndex, uint32_t& cluster);
+		// writes to the cached FAT and marks the FAT sector dirty, call sync() to write it to storage media
+		void setClusterValue (uint32_t cluster, uint32_t newClusterVal);
+		static bool clusterIsEndOfChain (uint32_t cluster);
+		unsigned int getClusterOffset (uint32_t cluster) const;
+		// returns Traits::FREE_CLUSTER if no cluster is free, searching from startCluster and wrapping around
+		uint32_t findFreeCluster (unsigned int startCluster);
+		// same as above, but for the first cluster of a run of runLength free clusters
+		uint32_t findFreeRun (unsigned int startCluster, unsigned int runLength);
+		void reserveCluster (uint32_t cluster);
+		// Reserves numClusters clusters and chains them onto the end of clusterModVec, taking the longest runs it can find
+		// first. Returns false without reserving anything if there aren't enough free clusters
+		bool reserveClusterRuns (std::vector<Fat16ClusterMod>& clusterModVec, unsigned int numClusters);
+		// Works out the offsets and cluster count of the active boot sector's volume and loads what the mount policy asks for.
+		// Returns false if the volume isn't of the Traits FAT type, or not even the first data cluster can be reached with 32 bit
+		// storage media offsets
+		bool mount();
+		// writes out the FAT and FSInfo sector and lets go of everything mount() loaded, so another volume can be mounted
+		void unmount();
+		unsigned int calculateNumClusters() const;
+		// the clusters past the last one that ends before FAT_MEDIA_OFFSET_LIMIT can't be read or written
+		unsigned int calculateNumReachableClusters() const;
+		void buildFreeClusterIndex();
+		void buildFreeClusterIndexIfDeferred();
+		void updateFreeClusterIndex (uint32_t cluster, uint32_t oldClusterVal, uint32_t newClusterVal);
+		// trusts the free cluster count and next free cluster hint of a valid FSInfo sector, as long as they are in range
+		void loadFsInfo (unsigned int partitionOffset);
+		void writeFsInfoIfChanged();
+
+		void writeEntryToStorageMedia (const Fat16Entry& entry, unsigned int entryOffset);
+		// searches a directory (0 for the root directory) on the storage media, following its cluster chain
+		bool findEntryInDirectory (uint32_t dirCluster, const char* filenameRaw, const char* extensionRaw, uint8_t* entryData);
+		uint32_t getDirectoryCluster (unsigned int directoryOffset) const;
+		static bool makeRawName (const std::string& filename, const std::string& extension, char* filenameRaw, char* extensionRaw);
+		// loads a whole directory (0 for the root directory) as the current directory, following its cluster chain
+		void loadCurrentDirectory (uint32_t dirCluster);
+		// Reads a whole directory with one read per run of adjacent clusters in its chain, and gives back the clusters (none for
+		// the root directory) so entry numbers can be mapped to where they are on the storage media
+		SharedData<uint8_t> readDirectory (uint32_t dirCluster, std::vector<uint32_t>& clusters);
+		unsigned int getDirectoryEntryOffset (const std::vector<uint32_t>& clusters, unsigned int entryNum) const;
+		// adds a cleared cluster to the end of a full subdirectory, returns false if there is no free cluster or the directory is
+		// already as big as it can be
+		bool growDirectory (std::vector<uint32_t>& clusters);
+		void loadCurrentDirectoryIfDeferred();
+		void setCurrentDirectoryEntry (unsigned int entryNum, const Fat16Entry& entry);
+		void writeDirectoryEntriesToVec (std::vector<Fat16Entry*>& vec, const uint8_t* directoryData, unsigned int numDirectoryEntries);
+		void freeDirectoryEntriesInVecAndClear (std::vector<Fat16Entry*>& vec);
+};
+
+#endif // FATFILEMANAGER_HPP
@@ -0,0 +1,47 @@
+#ifndef FATFREESCAN_HPP
+#define FATFREESCAN_HPP
+
+/**************************************************************************
+ * The FatFreeScan class holds the kernels used to find the free entries
+ * in a run of FAT entries when the free cluster index is built. Instead
+ * of putting every entry back together a byte at a time, a kernel
+ * compares many entries at once against zero (8 to 32 per step with
+ * SSE2, AVX2 or NEON, 2 or 4 per 64 bit word otherwise) and hands back
+ * one bit per entry, which can go straight into a FatBitmap. The best
+ * kernel the CPU supports is picked the first time a scan is done. The
+ * scalar kernels are the reference every other kernel must agree with.
+**************************************************************************/
+
+#include <stdint.h>
+
+enum class FatFreeScanKernel
+{
+	SCALAR,
+	SWAR, 	// 64 bit words, for any little endian CPU
+	SSE2,
+	AVX2,
+	NEON
+};
+
+class FatFreeScan
+{
+	public:
+		// bit n of freeMask is set if entry n is free, bits past numEntries in the last word are cleared, and the number of
+		// free entries is returned. freeMask needs room for ( numEntries + 31 ) / 32 words
+		static unsigned int scanFat16 (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask);
+		static unsigned int scanFat32 (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask);
+
+		static unsigned int scanFat16Scalar (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask);
+		static unsigned int scanFat32Scalar (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask);
+
+		static FatFreeScanKernel getKernel();
+		// returns false if the kernel wasn't compiled in or the CPU doesn't support it, only meant to be called while nothing
+		// is scanning (to compare the kernels against each other, etc)
+		static bool setKernel (const FatFreeScanKernel& kernel);
+		static bool kernelIsSupported (const FatFreeScanKernel& kernel);
+
+	private:
+		static FatFreeScanKernel& getActiveKernel();
+};
+
+#endif // FATFREESCAN_HPP
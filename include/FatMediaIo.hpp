@@ -0,0 +1,62 @@
+#ifndef FATMEDIAIO_HPP
+#define FATMEDIAIO_HPP
+
+/**************************************************************************
+ * The FatMediaIo class is what the file managers go through to read
+ * from and write to the storage media. Each access is tagged with what
+ * it is for (FAT, directory or file data). Access counts, byte totals
+ * and the last offset are kept for each type. While an
+ * IFatInstrumentation is set, latency histograms are kept too, and
+ * the instrumentation is told about each access as it happens. If an
+ * IAsyncStorageMedia is set, file data can also be transferred without
+ * blocking. Those transfers are counted, but can't be timed. If the
+ * file manager is used from more than one thread, the stats need a
+ * lock of their own.
+**************************************************************************/
+
+#include "IStorageMedia.hpp"
+#include "IFatInstrumentation.hpp"
+#include "IAsyncStorageMedia.hpp"
+#include "IFatLock.hpp"
+
+class FatMediaIo
+{
+	public:
+		FatMediaIo (IStorageMedia& storageMedia);
+
+		SharedData<uint8_t> read (const FatIoType& type, unsigned int sizeInBytes, unsigned int offsetInBytes);
+		void write (const FatIoType& type, const SharedData<uint8_t>& data, unsigned int offsetInBytes);
+
+		// Adds a transfer to the request and queues it with the async storage media. If none is set, or it can't queue the
+		// transfer, it is done synchronously and the transfer is completed before returning
+		void readAsync (const FatIoType& type, unsigned int sizeInBytes, unsigned int offsetInBytes, FatAsyncRequest& request);
+		void writeAsync (const FatIoType& type, const SharedData<uint8_t>& data, unsigned int offsetInBytes, FatAsyncRequest& request);
+
+		void setAsyncStorageMedia (IAsyncStorageMedia* asyncStorageMedia) { m_AsyncStorageMedia = asyncStorageMedia; }
+		IAsyncStorageMedia* getAsyncStorageMedia() { return m_AsyncStorageMedia; }
+
+		void setInstrumentation (IFatInstrumentation* instrumentation) { m_Instrumentation = instrumentation; }
+		IFatInstrumentation* getInstrumentation() { return m_Instrumentation; }
+
+		// returns a copy, so it can be compared against a later snapshot
+		FatIoStats getStats() const;
+		void resetStats();
+		// only held while the stats are updated or copied, never while the storage media is being accessed
+		void setStatsLock (IFatLock* statsLock) { m_StatsLock = statsLock; }
+
+		// Writes the stats as CSV, with a header line and then one line per type, so runs can be diffed or compared by a script.
+		// Returns the number of characters written, not counting the terminator. The output is cut short if the buffer is too small
+		static unsigned int formatStatsAsCsv (const FatIoStats& stats, char* buffer, unsigned int bufferSizeInBytes);
+
+	private:
+		IStorageMedia& 		m_StorageMedia;
+		IAsyncStorageMedia* 	m_AsyncStorageMedia;
+		IFatInstrumentation* 	m_Instrumentation;
+		FatIoStats 		m_Stats;
+		IFatLock* 		m_StatsLock;
+
+		void recordAccess (const FatIoType& type, unsigned int sizeInBytes, unsigned int offsetInBytes);
+		void recordLatency (const FatIoType& type, unsigned int sizeInBytes, unsigned int offsetInBytes, uint32_t startTimestamp);
+};
+
+#endif // FATMEDIAIO_HPP
@@ -0,0 +1,82 @@
+#ifndef FATSECTORCACHE_HPP
+#define FATSECTORCACHE_HPP
+
+/**************************************************************************
+ * The FatSectorCache class holds sectors of the FAT in memory for the
+ * file manager. It can hold the whole FAT, or a fixed number of
+ * sector sized pages. Nothing is allocated or read until the first
+ * sector is asked for. At that point the whole FAT is read in, or in
+ * paged mode just that sector, with the rest loaded on demand.
+ * When every page is in use, one is picked for eviction with the
+ * clock algorithm. Sectors that are written to are marked dirty. A
+ * dirty sector goes to the storage media when it is evicted or when
+ * flush() is called, whichever comes first.
+**************************************************************************/
+
+#include <stdint.h>
+#include <vector>
+
+#include "FatBitmap.hpp"
+#include "FatMediaIo.hpp"
+
+#define FAT_SECTOR_CACHE_WHOLE_FAT 	0 	// pass as the number of pages to keep the whole FAT in memory
+#define FAT_SECTOR_CACHE_NO_PAGE 	0xFFFFFFFF
+
+class IAllocator;
+
+class FatSectorCache
+{
+	public:
+		FatSectorCache (FatMediaIo& mediaIo, IAllocator* allocator = nullptr);
+		FatSectorCache (const FatSectorCache& other) = delete;
+		void operator= (const FatSectorCache& other) = delete;
+		~FatSectorCache();
+
+		// Any dirty sectors should be flushed before this is called again. If numPages is FAT_SECTOR_CACHE_WHOLE_FAT, or at least
+		// the size of the FAT, the whole FAT is held. If the allocator can't hold that many pages, it holds as many as fit
+		void init (unsigned int fatOffset, unsigned int sectorSizeInBytes, unsigned int numSectorsPerFat, unsigned int numFats,
+				unsigned int numPages);
+
+		// returns the cached sector of the FAT, loading it from the first FAT copy if necessary
+		const uint8_t* getSector (unsigned int sector);
+		// same as above, but also marks the sector dirty
+		uint8_t* getSectorForWrite (unsigned int sector);
+		// returns nullptr if the sector isn't cached, without loading it
+		const uint8_t* findSector (unsigned int sector) const;
+
+		// writes each run of adjacent dirty sectors once to every copy of the FAT
+		void flush();
+
+		bool isPaged() const { return m_NumPages < m_NumSectorsPerFat; }
+		unsigned int getNumPages() const { return m_NumPages; }
+		// true once the whole FAT has been read in, after which looking up a sector changes nothing in the cache
+		bool isResident() const { return m_PagesPtr && ! this->isPaged(); }
+
+	private:
+		FatMediaIo& 			m_MediaIo;
+		IAllocator* 			m_Allocator;
+		unsigned int 			m_FatOffset;
+		unsigned int 			m_SectorSizeInBytes;
+		unsigned int 			m_NumSectorsPerFat;
+		unsigned int 			m_NumFats;
+		unsigned int 			m_NumPages;
+
+		SharedData<uint8_t> 		m_PagesSharedData; // only used when the whole FAT is held without an allocator
+		uint8_t* 			m_PagesPtr;
+
+		std::vector<uint32_t> 		m_SectorToPage; // 32 bits wide, since a FAT32 FAT can have more than 65535 sectors
+		std::vector<uint32_t> 		m_PageToSector;
+		std::vector<bool> 		m_PageReferenced;
+		unsigned int 			m_ClockHand;
+
+		FatBitmap 			m_DirtySectors;
+
+		// allocates the pages, and reads in the whole FAT if it isn't paged
+		void allocatePages();
+		uint32_t loadSector (unsigned int sector);
+		uint32_t evictPage();
+		void writeSectorRun (unsigned int startSector, unsigned int numSectors);
+		void freePages();
+};
+
+#endif // FATSECTORCACHE_HPP
@@ -0,0 +1,136 @@
+#ifndef FATTRAITS_HPP
+#define FATTRAITS_HPP
+
+/**************************************************************************
+ * The FatTraits structs describe what differs between FAT widths, so the
+ * FatFileManager can be compiled once per width with the FAT entry size,
+ * end of chain and bad cluster markers and root directory layout all
+ * known at compile time. Chain walking, allocation and free cluster
+ * scanning then don't branch on the FAT type at runtime. Cluster numbers
+ * are passed around as uint32_t for every width. A volume is only
+ * mounted by the FatFileManager whose traits match its FAT type.
+**************************************************************************/
+
+#include <stdint.h>
+
+#include "BootSector.hpp"
+#include "Fat16Entry.hpp"
+#include "FatFreeScan.hpp"
+#include "FatSectorCache.hpp"
+
+#define FAT16_MIN_NUM_CLUSTERS 	4085 // a volume with fewer data clusters than this is FAT12
+#define FAT16_MAX_NUM_CLUSTERS 	65524 // cluster values from 0xFFF7 up are the bad cluster and end of chain markers
+
+struct Fat16Traits
+{
+	static constexpr unsigned int 	ENTRY_SIZE_IN_BYTES = 2;
+	static constexpr uint32_t 	FREE_CLUSTER = 0x0000;
+	static constexpr uint32_t 	RESERVED_CLUSTER = 0x0001;
+	static constexpr uint32_t 	BAD_CLUSTER = 0xFFF7;
+	static constexpr uint32_t 	END_OF_CHAIN_CLUSTER = 0xFFFF;
+	// the root directory is a fixed region between the FATs and the data region
+	static constexpr bool 		HAS_FIXED_ROOT_DIRECTORY = true;
+	static constexpr bool 		HAS_FS_INFO = false;
+	// the upper 16 bits of an entry's starting cluster aren't part of it, FAT16 uses that field for other things
+	static constexpr bool 		HAS_STARTING_CLUSTER_NUM_HIGH = false;
+	// a FAT16 FAT is at most 128KB, so it is held in memory whole
+	static constexpr unsigned int 	DEFAULT_NUM_FAT_CACHE_PAGES = FAT_SECTOR_CACHE_WHOLE_FAT;
+
+	static uint32_t readClusterValue (const uint8_t* entryPtr)
+	{
+		return entryPtr[0] | ( entryPtr[1] << 8 );
+	}
+
+	static void writeClusterValue (uint8_t* entryPtr, uint32_t clusterVal)
+	{
+		entryPtr[0] = ( clusterVal & 0x00FF );
+		entryPtr[1] = ( clusterVal & 0xFF00 ) >> 8;
+	}
+
+	static unsigned int scanForFreeClusters (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+	{
+		return FatFreeScan::scanFat16( entries, numEntries, freeMask );
+	}
+
+	static uint32_t getStartingClusterNum (const Fat16Entry& entry)
+	{
+		return entry.getStartingClusterNum();
+	}
+
+	static void setStartingClusterNum (Fat16Entry& entry, uint32_t clusterNum)
+	{
+		entry.setStartingClusterNum( clusterNum );
+	}
+
+	static uint32_t getRootDirectoryCluster (const BootSector&)
+	{
+		return 0;
+	}
+
+	// FAT12 has the same layout but 12 bit FAT entries, so it is told apart by its cluster count
+	static bool isFatType (const BootSector& bootSector, unsigned int numDataClusters)
+	{
+		return ( ! bootSector.isFat32() && numDataClusters >= FAT16_MIN_NUM_CLUSTERS && numDataClusters <= FAT16_MAX_NUM_CLUSTERS );
+	}
+};
+
+struct Fat32Traits
+{
+	static constexpr unsigned int 	ENTRY_SIZE_IN_BYTES = 4;
+	static constexpr uint32_t 	FREE_CLUSTER = 0x00000000;
+	static constexpr uint32_t 	RESERVED_CLUSTER = 0x00000001;
+	static constexpr uint32_t 	BAD_CLUSTER = 0x0FFFFFF7;
+	static constexpr uint32_t 	END_OF_CHAIN_CLUSTER = 0x0FFFFFFF;
+	// the root directory is a cluster chain like any other directory
+	static constexpr bool 		HAS_FIXED_ROOT_DIRECTORY = false;
+	// the free cluster count and next free cluster are cached in the FSInfo sector
+	static constexpr bool 		HAS_FS_INFO = true;
+	// an entry's starting cluster is split into a low and a high 16 bits
+	static constexpr bool 		HAS_STARTING_CLUSTER_NUM_HIGH = true;
+	// a FAT32 FAT can run to megabytes, so only this many sectors of it are held in memory at once
+	static constexpr unsigned int 	DEFAULT_NUM_FAT_CACHE_PAGES = 64;
+
+	// only the low 28 bits of a FAT32 entry are the cluster value
+	static uint32_t readClusterValue (const uint8_t* entryPtr)
+	{
+		return ( entryPtr[0] | (entryPtr[1] << 8) | (entryPtr[2] << 16) | (static_cast<uint32_t>(entryPtr[3]) << 24) ) & 0x0FFFFFFF;
+	}
+
+	// the top 4 bits are reserved, and have to be left as they are
+	static void writeClusterValue (uint8_t* entryPtr, uint32_t clusterVal)
+	{
+		entryPtr[0] = ( clusterVal & 0x000000FF );
+		entryPtr[1] = ( clusterVal & 0x0000FF00 ) >> 8;
+		entryPtr[2] = ( clusterVal & 0x00FF0000 ) >> 16;
+		entryPtr[3] = ( entryPtr[3] & 0xF0 ) | ( (clusterVal & 0x0F000000) >> 24 );
+	}
+
+	static unsigned int scanForFreeClusters (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+	{
+		return FatFreeScan::scanFat32( entries, numEntries, freeMask );
+	}
+
+	static uint32_t getStartingClusterNum (const Fat16Entry& entry)
+	{
+		return ( static_cast<uint32_t>(entry.getStartingClusterNumHigh()) << 16 ) | entry.getStartingClusterNum();
+	}
+
+	static void setStartingClusterNum (Fat16Entry& entry, uint32_t clusterNum)
+	{
+		entry.setStartingClusterNum( clusterNum & 0xFFFF );
+		entry.setStartingClusterNumHigh( clusterNum >> 16 );
+	}
+
+	static uint32_t getRootDirectoryCluster (const BootSector& bootSector)
+	{
+		return bootSector.getClusterNumForRoot();
+	}
+
+	// the boot sector layout is what sets FAT32 apart, since some formatters make FAT32 volumes with few clusters
+	static bool isFatType (const BootSector& bootSector, unsigned int)
+	{
+		return bootSector.isFat32();
+	}
+};
+
+#endif // FATTRAITS_HPP
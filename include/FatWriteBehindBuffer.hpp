@@ -0,0 +1,83 @@
+#ifndef FATWRITEBEHINDBUFFER_HPP
+#define FATWRITEBEHINDBUFFER_HPP
+
+/**************************************************************************
+ * The FatWriteBehindBuffer class is a lock free single producer, single
+ * consumer ring buffer for streaming writes. A time critical writer
+ * pushes data into it without touching the file system, and a flush
+ * task drains it into a file through the file manager in large
+ * batches. Exactly one context may push and exactly one may drain, but
+ * the two may run concurrently (a thread and an interrupt, two
+ * threads, etc). A push that doesn't fit is rejected whole, and counted,
+ * so the writer can decide whether to retry or drop the data.
+**************************************************************************/
+
+#include <stdint.h>
+#include <atomic>
+
+#include "SharedData.hpp"
+
+#define FAT_WRITE_BEHIND_MAX_SIZE 	32768 // the most an allocator is asked for, the size is rounded down to a power of two
+#define FAT_WRITE_BEHIND_MIN_SIZE 	512 // the smallest sector size, smaller sizes are rounded up to it
+
+class IAllocator;
+
+struct FatWriteBehindStats
+{
+	uint32_t numBytesPushed;
+	uint32_t numPushesRejected; 	// pushes that didn't fit, which means the flush task isn't keeping up
+	uint32_t highWaterMarkInBytes; 	// the most ever queued at once
+	uint32_t numBatchesDrained;
+	uint32_t numBytesDrained;
+};
+
+class FatWriteBehindBuffer
+{
+	public:
+		FatWriteBehindBuffer (unsigned int sizeInBytes, IAllocator* allocator = nullptr);
+		FatWriteBehindBuffer (const FatWriteBehindBuffer& other) = delete;
+		void operator= (const FatWriteBehindBuffer& other) = delete;
+		~FatWriteBehindBuffer();
+
+		unsigned int getSizeInBytes() const { return m_SizeInBytes; }
+
+		// producer side, returns false without pushing anything if there isn't room for all of the data
+		bool push (const uint8_t* data, unsigned int numBytes);
+
+		// consumer side, the number of bytes queued can only grow until the consumer pops some. peek copies out the oldest
+		// bytes queued without taking them out, so they can be written before discard hands their space back to the producer.
+		// pop does both
+		unsigned int getNumBytesQueued() const;
+		void peek (uint8_t* data, unsigned int numBytes) const;
+		void discard (unsigned int numBytes);
+		void pop (uint8_t* data, unsigned int numBytes);
+
+		// consumer side, a buffer to drain batches into that is only allocated again if a different size is asked for
+		SharedData<uint8_t>& getDrainBatch (unsigned int sizeInBytes);
+
+		// read by either side, so the counts may be slightly out of date with respect to each other
+		FatWriteBehindStats getStats() const;
+
+	private:
+		IAllocator* 		m_Allocator;
+		uint8_t* 		m_Bytes;
+		unsigned int 		m_SizeInBytes;
+
+		// free running, so that head - tail is the number of bytes queued even once they wrap around
+		std::atomic<uint32_t> 	m_Head; // only written by the producer
+		std::atomic<uint32_t> 	m_Tail; // only written by the consumer
+
+		// each is only written by one side, but may be read by the other
+		std::atomic<uint32_t> 	m_NumBytesPushed;
+		std::atomic<uint32_t> 	m_NumPushesRejected;
+		std::atomic<uint32_t> 	m_HighWaterMarkInBytes;
+		std::atomic<uint32_t> 	m_NumBatchesDrained;
+		std::atomic<uint32_t> 	m_NumBytesDrained;
+
+		SharedData<uint8_t> 	m_DrainBatch;
+
+		// only called by the side that writes the count, so a load and a store is enough
+		static void addToCount (std::atomic<uint32_t>& count, uint32_t value);
+};
+
+#endif // FATWRITEBEHINDBUFFER_HPP
@@ -0,0 +1,27 @@
+#ifndef IASYNCSTORAGEMEDIA_HPP
+#define IASYNCSTORAGEMEDIA_HPP
+
+/**************************************************************************
+ * An IAsyncStorageMedia subclass lets storage media that can transfer
+ * in the background (DMA driven SD cards, flash over SPI with DMA, etc)
+ * take reads and writes of file data without blocking. Each transfer
+ * is queued by the media, which calls completeTransfer() on the given
+ * request once it is done. The file manager still uses the blocking
+ * IStorageMedia for the FAT and directories.
+**************************************************************************/
+
+#include "SharedData.hpp"
+#include "FatAsyncRequest.hpp"
+
+class IAsyncStorageMedia
+{
+	public:
+		virtual ~IAsyncStorageMedia() {}
+
+		// Both return false if the transfer can't be queued right now, in which case it is done synchronously instead. The data
+		// given to a write is only released once the write completes, so it must not be modified before then
+		virtual bool readFromMediaAsync (unsigned int sizeInBytes, unsigned int offsetInBytes, FatAsyncRequest& request) = 0;
+		virtual bool writeToMediaAsync (const SharedData<uint8_t>& data, unsigned int offsetInBytes, FatAsyncRequest& request) = 0;
+};
+
+#endif // IASYNCSTORAGEMEDIA_HPP
@@ -9,10 +9,12 @@
 
 #include "IStorageMedia.hpp"
 #include "BootSector.hpp"
+#include "FatMediaIo.hpp"
 
 #include <vector>
 
 class PartitionTable;
+class Fat16FileHandle;
 
 class IFatFileManager
 {
@@ -20,16 +22,30 @@ class IFatFileManager
 		IFatFileManager (IStorageMedia& storageMedia);
 		virtual ~IFatFileManager();
 
-		bool isValidFatFileSystem();
+		virtual bool isValidFatFileSystem();
 
 		virtual void changePartition (unsigned int partitionNum);
 
+		// ends any read or write in progress on the handle, called by the handle when it is closed or destroyed
+		virtual void closeFile (Fat16FileHandle& handle) = 0;
+
 		BootSector* getActiveBootSector() { return m_ActiveBootSector; }
 
 		std::vector<PartitionTable>* getPartitionTables() { return &m_PartitionTables; }
 
+		// Every storage media access the file system makes is counted by type (FAT, directory or file data, read or write), so
+		// metadata traffic can be told apart from file data. Latencies are only measured while instrumentation is set
+		void setInstrumentation (IFatInstrumentation* instrumentation) { m_MediaIo.setInstrumentation( instrumentation ); }
+		FatIoStats getIoStats() const { return m_MediaIo.getStats(); }
+		void resetIoStats() { m_MediaIo.resetStats(); }
+
+		// lets file data be read and written without blocking through the async functions of the subclass, null to go back to
+		// doing those synchronously on the storage media
+		void setAsyncStorageMedia (IAsyncStorageMedia* asyncStorageMedia) { m_MediaIo.setAsyncStorageMedia( asyncStorageMedia ); }
+
 	protected:
 		IStorageMedia& 			m_StorageMedia;
+		FatMediaIo 			m_MediaIo;
 		unsigned int 			m_ActivePartitionNum;
 		std::vector<PartitionTable> 	m_PartitionTables;
 		BootSector* 			m_ActiveBootSector;
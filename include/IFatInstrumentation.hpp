@@ -0,0 +1,61 @@
+#ifndef IFATINSTRUMENTATION_HPP
+#define IFATINSTRUMENTATION_HPP
+
+/**************************************************************************
+ * An IFatInstrumentation subclass lets the platform measure what the
+ * file manager is doing. The file manager has no clock of its own, so
+ * timestamps come from getTimestamp(), in whatever unit the platform
+ * likes (microseconds, timer ticks, etc). The other functions are
+ * hooks that do nothing unless overridden.
+**************************************************************************/
+
+#include <stdint.h>
+
+#define FAT_IO_NUM_TYPES 		6
+#define FAT_IO_NUM_LATENCY_BUCKETS 	16 // bucket n counts accesses that took less than 2^n timestamp units, the last takes the rest
+
+// what a read or write to the storage media was for, used to tell metadata accesses from file data accesses
+enum class FatIoType
+{
+	FAT_READ = 0,
+	FAT_WRITE = 1,
+	DIRECTORY_READ = 2,
+	DIRECTORY_WRITE = 3,
+	DATA_READ = 4,
+	DATA_WRITE = 5
+};
+
+struct FatIoTypeStats
+{
+	uint32_t numAccesses;
+	uint64_t numBytes;
+	uint32_t lastOffsetInBytes;
+	// latencies are only recorded while an IFatInstrumentation is set, since they need its timestamps
+	uint64_t totalLatency;
+	uint32_t maxLatency;
+	uint32_t latencyHistogram[FAT_IO_NUM_LATENCY_BUCKETS];
+};
+
+struct FatIoStats
+{
+	FatIoTypeStats types[FAT_IO_NUM_TYPES]; // indexed by FatIoType
+};
+
+class IFatInstrumentation
+{
+	public:
+		virtual ~IFatInstrumentation() {}
+
+		virtual uint32_t getTimestamp() = 0;
+
+		// called once the file system has been mounted, with the timestamps from the start and end of mounting it
+		virtual void onMount (uint32_t startTimestamp, uint32_t endTimestamp) { (void)startTimestamp; (void)endTimestamp; }
+
+		// called after every read or write the file manager makes to the storage media, latency is in timestamp units
+		virtual void onStorageMediaAccess (const FatIoType& type, unsigned int offsetInBytes, unsigned int sizeInBytes, uint32_t latency)
+		{
+			(void)type; (void)offsetInBytes; (void)sizeInBytes; (void)latency;
+		}
+};
+
+#endif // IFATINSTRUMENTATION_HPP
@@ -0,0 +1,69 @@
+#ifndef IFATLOCK_HPP
+#define IFATLOCK_HPP
+
+/**************************************************************************
+ * An IFatLock subclass wraps whatever lock the platform has (an RTOS
+ * mutex, std::shared_mutex, etc) so the file manager can be used from
+ * more than one thread. Platforms with only a plain mutex can leave the
+ * shared functions alone, which then just take the lock exclusively.
+ * The FatLockGuard class holds a lock for the scope it is declared in,
+ * and does nothing if the lock is null, so locking costs nothing when
+ * no locks are set.
+**************************************************************************/
+
+enum class FatLockMode
+{
+	EXCLUSIVE,
+	SHARED
+};
+
+class IFatLock
+{
+	public:
+		virtual ~IFatLock() {}
+
+		virtual void lock() = 0;
+		virtual void unlock() = 0;
+
+		virtual void lockShared() { this->lock(); }
+		virtual void unlockShared() { this->unlock(); }
+};
+
+class FatLockGuard
+{
+	public:
+		FatLockGuard (IFatLock* lock, const FatLockMode& mode = FatLockMode::EXCLUSIVE) :
+			m_Lock( lock ),
+			m_Mode( mode )
+		{
+			if ( ! m_Lock ) return;
+
+			if ( m_Mode == FatLockMode::SHARED ) m_Lock->lockShared();
+			else m_Lock->lock();
+		}
+		FatLockGuard (const FatLockGuard& other) = delete;
+		void operator= (const FatLockGuard& other) = delete;
+		~FatLockGuard()
+		{
+			if ( ! m_Lock ) return;
+
+			if ( m_Mode == FatLockMode::SHARED ) m_Lock->unlockShared();
+			else m_Lock->unlock();
+		}
+
+		// the lock is let go of before being taken exclusively, so anything read under the shared lock needs to be read again
+		void upgrade()
+		{
+			if ( ! m_Lock || m_Mode == FatLockMode::EXCLUSIVE ) return;
+
+			m_Lock->unlockShared();
+			m_Lock->lock();
+			m_Mode = FatLockMode::EXCLUSIVE;
+		}
+
+	private:
+		IFatLock* 	m_Lock;
+		FatLockMode 	m_Mode;
+};
+
+#endif // IFATLOCK_HPP
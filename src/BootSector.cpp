@@ -63,8 +63,14 @@ BootSector::BootSector (uint8_t* offset, const PartitionType& partitionType) :
 					| offset[BOOT_SEC_NUM_SECS_ON_DISK_GT_32MB_OFFSET];
 	}
 
+	// without a partition table to say so, a FAT32 volume is told apart by having no FAT16 sectors per FAT
+	if ( m_PartitionType == PartitionType::EMPTY && m_NumSectorsPerFat == 0 && m_NumSectorsForFat != 0 )
+	{
+		m_PartitionType = PartitionType::FAT32_LBA;
+	}
+
 	// if the file system type isn't FAT16 or FAT12, we need to use FAT32 offsets
-	if ( partitionType == PartitionType::FAT32_LTOREQ_2GB || partitionType == PartitionType::FAT32_LBA )
+	if ( this->isFat32() )
 	{
 		m_DriveNum = offset[BOOT_SEC_DRIVE_NUMBER_FAT32_OFFSET];
 		m_CurrentHead = offset[BOOT_SEC_CURRENT_HEAD_FAT32_OFFSET];
@@ -177,10 +183,14 @@ uint8_t BootSector::getMediaDescriptor() const
 	return m_MediaDescriptor;
 }
 
-uint16_t BootSector::getNumSectorsPerFat() const
+bool BootSector::isFat32() const
+{
+	return ( m_PartitionType == PartitionType::FAT32_LTOREQ_2GB || m_PartitionType == PartitionType::FAT32_LBA );
+}
+
+uint32_t BootSector::getNumSectorsPerFat() const
 {
-	if ( m_PartitionType == PartitionType::FAT32_LTOREQ_2GB
-			|| m_PartitionType == PartitionType::FAT32_LBA )
+	if ( this->isFat32() )
 	{
 		return m_NumSectorsForFat;
 	}
@@ -0,0 +1,101 @@
+#include "Fat16DentryCache.hpp"
+
+#include <string.h>
+
+Fat16DentryCache::Fat16DentryCache (unsigned int numDentries) :
+	m_Dentries(),
+	m_UseCounter( 0 )
+{
+	this->setNumDentries( numDentries );
+}
+
+Fat16DentryCache::~Fat16DentryCache()
+{
+}
+
+void Fat16DentryCache::setNumDentries (unsigned int numDentries)
+{
+	m_Dentries.resize( numDentries );
+	this->clear();
+}
+
+const uint8_t* Fat16DentryCache::find (uint32_t dirCluster, const char* filenameRaw, const char* extensionRaw)
+{
+	Fat16Dentry* dentry = this->findDentry( dirCluster, filenameRaw, extensionRaw );
+	if ( dentry == nullptr ) return nullptr;
+
+	m_UseCounter++;
+	dentry->lastUsed = m_UseCounter;
+
+	return dentry->entryData;
+}
+
+void Fat16DentryCache::insert (uint32_t dirCluster, const uint8_t* entryData)
+{
+	if ( m_Dentries.empty() ) return;
+
+	const char* filenameRaw = reinterpret_cast<const char*>( &entryData[FAT16_FILENAME_OFFSET] );
+	const char* extensionRaw = reinterpret_cast<const char*>( &entryData[FAT16_EXTENSION_OFFSET] );
+
+	// replace the existing entry if there is one, otherwise the first invalid or least recently used entry
+	Fat16Dentry* dentryToReplace = this->findDentry( dirCluster, filenameRaw, extensionRaw );
+	if ( dentryToReplace == nullptr )
+	{
+		dentryToReplace = &m_Dentries[0];
+		for ( Fat16Dentry& dentry : m_Dentries )
+		{
+			if ( ! dentry.isValid )
+			{
+				dentryToReplace = &dentry;
+
+				break;
+			}
+
+			if ( dentry.lastUsed < dentryToReplace->lastUsed )
+			{
+				dentryToReplace = &dentry;
+			}
+		}
+	}
+
+	m_UseCounter++;
+	dentryToReplace->isValid = true;
+	dentryToReplace->dirCluster = dirCluster;
+	dentryToReplace->lastUsed = m_UseCounter;
+	memcpy( dentryToReplace->entryData, entryData, FAT16_ENTRY_SIZE );
+}
+
+void Fat16DentryCache::remove (uint32_t dirCluster, const char* filenameRaw, const char* extensionRaw)
+{
+	Fat16Dentry* dentry = this->findDentry( dirCluster, filenameRaw, extensionRaw );
+	if ( dentry != nullptr )
+	{
+		dentry->isValid = false;
+	}
+}
+
+void Fat16DentryCache::clear()
+{
+	for ( Fat16Dentry& dentry : m_Dentries )
+	{
+		dentry.isValid = false;
+		dentry.lastUsed = 0;
+	}
+
+	m_UseCounter = 0;
+}
+
+Fat16Dentry* Fat16DentryCache::findDentry (uint32_t dirCluster, const char* filenameRaw, const char* extensionRaw)
+{
+	for ( Fat16Dentry& dentry : m_Dentries )
+	{
+		if ( dentry.isValid && dentry.dirCluster == dirCluster
+				&& memcmp(&dentry.entryData[FAT16_FILENAME_OFFSET], filenameRaw, FAT16_FILENAME_SIZE) == 0
+				&& memcmp(&dentry.entryData[FAT16_EXTENSION_OFFSET], extensionRaw, FAT16_EXTENSION_SIZE) == 0 )
+		{
+			return &dentry;
+		}
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,164 @@
+#include "Fat16DirectoryIndex.hpp"
+
+#include <string.h>
+
+// slot values, anything else holds a hash and an entry number
+#define SLOT_EMPTY 		0xFFFFFFFFFFFFFFFFull
+#define SLOT_REMOVED 		0xFFFFFFFFFFFFFFFEull
+#define SLOT_MIN_NUM_SLOTS 	16
+#define SLOT_MAX_NUM_SLOTS 	0x20000 // twice the 65536 entries a directory can have
+
+Fat16DirectoryIndex::Fat16DirectoryIndex() :
+	m_Slots(),
+	m_NumUsedSlots( 0 ),
+	m_NumEntries( 0 )
+{
+}
+
+Fat16DirectoryIndex::~Fat16DirectoryIndex()
+{
+}
+
+void Fat16DirectoryIndex::build (const uint8_t* directoryData, unsigned int numEntries)
+{
+	this->clear();
+	this->rehash( numEntries );
+
+	for ( unsigned int entryNum = 0; entryNum < numEntries; entryNum++ )
+	{
+		this->insert( &directoryData[entryNum * FAT16_ENTRY_SIZE], entryNum );
+	}
+}
+
+void Fat16DirectoryIndex::clear()
+{
+	m_Slots.clear();
+	m_NumUsedSlots = 0;
+	m_NumEntries = 0;
+}
+
+void Fat16DirectoryIndex::insert (const uint8_t* entryData, unsigned int entryNum)
+{
+	const uint8_t firstCharacter = entryData[FAT16_FILENAME_OFFSET];
+	if ( firstCharacter == 0x00 || firstCharacter == 0xE5 ) return;
+
+	// keep the load factor (counting removed slots) at or below one half. Once the table is as big as it gets, only removed
+	// slots can be dropped to make room, so it isn't rehashed for nothing on every insert
+	if ( (m_NumUsedSlots + 1) * 2 > m_Slots.size() && (m_Slots.size() < SLOT_MAX_NUM_SLOTS || m_NumUsedSlots > m_NumEntries) )
+	{
+		this->rehash( m_NumEntries + 1 );
+	}
+
+	const uint32_t hash = Fat16DirectoryIndex::hashName( reinterpret_cast<const char*>(&entryData[FAT16_FILENAME_OFFSET]),
+								reinterpret_cast<const char*>(&entryData[FAT16_EXTENSION_OFFSET]) );
+	this->insertSlot( (static_cast<uint64_t>(hash) << 32) | entryNum );
+	m_NumEntries++;
+}
+
+void Fat16DirectoryIndex::remove (const uint8_t* entryData, unsigned int entryNum)
+{
+	if ( m_Slots.empty() ) return;
+
+	const uint32_t hash = Fat16DirectoryIndex::hashName( reinterpret_cast<const char*>(&entryData[FAT16_FILENAME_OFFSET]),
+								reinterpret_cast<const char*>(&entryData[FAT16_EXTENSION_OFFSET]) );
+	const uint64_t slotVal = ( static_cast<uint64_t>(hash) << 32 ) | entryNum;
+	const unsigned int mask = m_Slots.size() - 1;
+
+	for ( unsigned int slot = hash & mask; m_Slots[slot] != SLOT_EMPTY; slot = (slot + 1) & mask )
+	{
+		if ( m_Slots[slot] == slotVal )
+		{
+			m_Slots[slot] = SLOT_REMOVED;
+			m_NumEntries--;
+
+			return;
+		}
+	}
+}
+
+unsigned int Fat16DirectoryIndex::find (const char* filenameRaw, const char* extensionRaw, const uint8_t* directoryData,
+						unsigned int numEntries) const
+{
+	if ( m_Slots.empty() ) return FAT16_DIRECTORY_INDEX_NOT_FOUND;
+
+	const uint32_t hash = Fat16DirectoryIndex::hashName( filenameRaw, extensionRaw );
+	const unsigned int mask = m_Slots.size() - 1;
+
+	for ( unsigned int slot = hash & mask; m_Slots[slot] != SLOT_EMPTY; slot = (slot + 1) & mask )
+	{
+		const uint64_t slotVal = m_Slots[slot];
+		if ( slotVal == SLOT_REMOVED || (slotVal >> 32) != hash ) continue;
+
+		const unsigned int entryNum = static_cast<uint32_t>( slotVal );
+		if ( entryNum < numEntries
+				&& Fat16DirectoryIndex::namesMatch(&directoryData[entryNum * FAT16_ENTRY_SIZE], filenameRaw, extensionRaw) )
+		{
+			return entryNum;
+		}
+	}
+
+	return FAT16_DIRECTORY_INDEX_NOT_FOUND;
+}
+
+uint32_t Fat16DirectoryIndex::hashName (const char* filenameRaw, const char* extensionRaw)
+{
+	// 32 bit FNV-1a
+	uint32_t hash = 2166136261u;
+	for ( unsigned int character = 0; character < FAT16_FILENAME_SIZE; character++ )
+	{
+		hash = ( hash ^ static_cast<uint8_t>(filenameRaw[character]) ) * 16777619u;
+	}
+	for ( unsigned int character = 0; character < FAT16_EXTENSION_SIZE; character++ )
+	{
+		hash = ( hash ^ static_cast<uint8_t>(extensionRaw[character]) ) * 16777619u;
+	}
+
+	return hash;
+}
+
+bool Fat16DirectoryIndex::namesMatch (const uint8_t* entryData, const char* filenameRaw, const char* extensionRaw)
+{
+	if ( memcmp(&entryData[FAT16_FILENAME_OFFSET], filenameRaw, FAT16_FILENAME_SIZE) == 0
+			&& memcmp(&entryData[FAT16_EXTENSION_OFFSET], extensionRaw, FAT16_EXTENSION_SIZE) == 0 )
+	{
+		return true;
+	}
+
+	return false;
+}
+
+void Fat16DirectoryIndex::insertSlot (uint64_t slotVal)
+{
+	const unsigned int mask = m_Slots.size() - 1;
+	unsigned int slot = static_cast<uint32_t>( slotVal >> 32 ) & mask;
+	while ( m_Slots[slot] != SLOT_EMPTY && m_Slots[slot] != SLOT_REMOVED )
+	{
+		slot = ( slot + 1 ) & mask;
+	}
+
+	if ( m_Slots[slot] == SLOT_EMPTY ) m_NumUsedSlots++;
+	m_Slots[slot] = slotVal;
+}
+
+void Fat16DirectoryIndex::rehash (unsigned int minNumEntries)
+{
+	// the table size is a power of two at least twice the number of entries, which is as big as the biggest directory needs
+	unsigned int numSlots = SLOT_MIN_NUM_SLOTS;
+	while ( numSlots < minNumEntries * 2 && numSlots < SLOT_MAX_NUM_SLOTS )
+	{
+		numSlots *= 2;
+	}
+
+	std::vector<uint64_t> oldSlots( numSlots, SLOT_EMPTY );
+	oldSlots.swap( m_Slots );
+	m_NumUsedSlots = 0;
+
+	// removed slots are dropped here, which is what keeps probe sequences short after lots of deleting
+	for ( const uint64_t slotVal : oldSlots )
+	{
+		if ( slotVal != SLOT_EMPTY && slotVal != SLOT_REMOVED )
+		{
+			this->insertSlot( slotVal );
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#include "Fat16DirectoryView.hpp"
+
+#include <string.h>
+
+void Fat16EntryView::getFilenameDisplay (char* displayName) const
+{
+	const Fat16Entry entry = this->toEntry();
+
+	strcpy( displayName, entry.getFilenameDisplay() );
+}
+
+uint32_t Fat16EntryView::getStartingClusterNum() const
+{
+	const uint32_t startingClusterNumLow = ( m_EntryData[FAT16_STARTING_CLUSTER_NUM_OFFSET + 1] << 8 )
+						| m_EntryData[FAT16_STARTING_CLUSTER_NUM_OFFSET];
+	if ( ! m_HasStartingClusterNumHigh ) return startingClusterNumLow;
+
+	const uint32_t startingClusterNumHigh = ( m_EntryData[FAT16_STARTING_CLUSTER_NUM_HIGH_OFFSET + 1] << 8 )
+						| m_EntryData[FAT16_STARTING_CLUSTER_NUM_HIGH_OFFSET];
+
+	return ( startingClusterNumHigh << 16 ) | startingClusterNumLow;
+}
+
+uint32_t Fat16EntryView::getFileSizeInBytes() const
+{
+	// each byte is widened before it is shifted, since shifting a promoted int into its sign bit is undefined for 2GB and up
+	return ( static_cast<uint32_t>(m_EntryData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 3]) << 24 )
+		| ( static_cast<uint32_t>(m_EntryData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 2]) << 16 )
+		| ( static_cast<uint32_t>(m_EntryData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 1]) << 8 )
+		| static_cast<uint32_t>( m_EntryData[FAT16_FILE_SIZE_IN_BYTES_OFFSET] );
+}
+
+Fat16DirectoryView::Fat16DirectoryView (const SharedData<uint8_t>& directoryData, bool skipUnusedAndDeletedEntries,
+						bool hasStartingClusterNumHigh) :
+	m_DirectoryData( directoryData ),
+	m_DirectoryDataPtr( m_DirectoryData.getPtr() ),
+	m_NumDirectoryEntries( m_DirectoryData.getSizeInBytes() / FAT16_ENTRY_SIZE ),
+	m_SkipUnusedAndDeletedEntries( skipUnusedAndDeletedEntries ),
+	m_HasStartingClusterNumHigh( hasStartingClusterNumHigh ),
+	m_UsedEntryNums()
+{
+	if ( m_SkipUnusedAndDeletedEntries )
+	{
+		for ( unsigned int entryNum = 0; entryNum < m_NumDirectoryEntries; entryNum++ )
+		{
+			const Fat16EntryView entry( &m_DirectoryDataPtr[entryNum * FAT16_ENTRY_SIZE] );
+
+			// an unused entry marks the end of the directory
+			if ( entry.isUnusedEntry() ) break;
+
+			if ( ! entry.isDeletedEntry() )
+			{
+				m_UsedEntryNums.push_back( entryNum );
+			}
+		}
+	}
+}
+
+Fat16DirectoryView::~Fat16DirectoryView()
+{
+}
+
+unsigned int Fat16DirectoryView::getNumEntries() const
+{
+	return ( m_SkipUnusedAndDeletedEntries ) ? m_UsedEntryNums.size() : m_NumDirectoryEntries;
+}
+
+Fat16EntryView Fat16DirectoryView::getEntry (unsigned int viewEntryNum) const
+{
+	return Fat16EntryView( &m_DirectoryDataPtr[this->getDirectoryEntryNum(viewEntryNum) * FAT16_ENTRY_SIZE],
+				m_HasStartingClusterNumHigh );
+}
+
+unsigned int Fat16DirectoryView::getDirectoryEntryNum (unsigned int viewEntryNum) const
+{
+	return ( m_SkipUnusedAndDeletedEntries ) ? m_UsedEntryNums.at( viewEntryNum ) : viewEntryNum;
+}
@@ -2,46 +2,20 @@
 
 #include <string.h>
 
-Fat16Entry::Fat16Entry (uint8_t* offset) :
+Fat16Entry::Fat16Entry (const uint8_t* offset) :
 	m_UnderlyingData{ 0 },
-	m_Filename{ 0 },
-	m_Extension{ 0 },
-	m_FileAttributes( offset[FAT16_ATTRIBUTES_OFFSET] ),
-	m_TimeLastUpdated( (offset[FAT16_TIME_LAST_UPDATED_OFFSET + 1] << 8) | offset[FAT16_TIME_LAST_UPDATED_OFFSET] ),
-	m_DateLastUpdated( (offset[FAT16_DATE_LAST_UPDATED_OFFSET + 1] << 8) | offset[FAT16_DATE_LAST_UPDATED_OFFSET] ),
-	m_StartingClusterNum( (offset[FAT16_STARTING_CLUSTER_NUM_OFFSET + 1] << 8) | offset[FAT16_STARTING_CLUSTER_NUM_OFFSET] ),
-	m_FileSizeInBytes( (offset[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 3] << 24)
-				| (offset[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 2] << 16)
-				| (offset[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 1] << 8)
-				| offset[FAT16_FILE_SIZE_IN_BYTES_OFFSET] ),
-	m_IsInvalidEntry( false ),
-	m_FileTransferInProgress( false ),
-	m_CurrentFileSector( 0 ),
-	m_CurrentFileCluster( 0 ),
-	m_CurrentDirOffset( 0 ),
-	m_CurrentFileOffset( 0 ),
-	m_NumBytesRead( 0 ),
-	m_ClustersToModify()
-{
-	for ( unsigned int byte = 0; byte < FAT16_ENTRY_SIZE; byte++ )
-	{
-		m_UnderlyingData[byte] = offset[byte];
-	}
-
-	for ( unsigned int character = 0; character < FAT16_FILENAME_SIZE; character++ )
-	{
-		m_Filename[character] = offset[FAT16_FILENAME_OFFSET + character];
-	}
-
-	for ( unsigned int character = 0; character < FAT16_EXTENSION_SIZE; character++ )
-	{
-		m_Extension[character] = offset[FAT16_EXTENSION_OFFSET + character];
-	}
+	m_FilenameWithExtension{ 0 },
+	m_IsInvalidEntry( false )
+{
+	memcpy( m_UnderlyingData, offset, FAT16_ENTRY_SIZE );
 
 	this->createFilenameDisplayString();
 }
 
-Fat16Entry::Fat16Entry (const std::string& filename, const std::string& extension)
+Fat16Entry::Fat16Entry (const std::string& filename, const std::string& extension) :
+	m_UnderlyingData{ 0 },
+	m_FilenameWithExtension{ 0 },
+	m_IsInvalidEntry( false )
 {
 	if ( filename.size() > FAT16_FILENAME_SIZE )
 	{
@@ -85,88 +59,8 @@ Fat16Entry::Fat16Entry (const std::string& filename, const std::string& extensio
 	}
 }
 
-Fat16Entry::Fat16Entry (const Fat16Entry& other) :
-	m_UnderlyingData{ 0 },
-	m_Filename{ 0 },
-	m_Extension{ 0 },
-	m_FilenameWithExtension{ 0 },
-	m_FileAttributes( other.m_FileAttributes ),
-	m_TimeLastUpdated( other.m_TimeLastUpdated ),
-	m_DateLastUpdated( other.m_DateLastUpdated ),
-	m_StartingClusterNum( other.m_StartingClusterNum ),
-	m_FileSizeInBytes( other.m_FileSizeInBytes ),
-	m_IsInvalidEntry( other.m_IsInvalidEntry ),
-	m_FileTransferInProgress( other.m_FileTransferInProgress ),
-	m_CurrentFileSector( other.m_CurrentFileSector ),
-	m_CurrentFileCluster( other.m_CurrentFileCluster ),
-	m_CurrentDirOffset( other.m_CurrentDirOffset ),
-	m_CurrentFileOffset( other.m_CurrentFileOffset ),
-	m_ClustersToModify()
-{
-	for ( unsigned int byte = 0; byte < FAT16_ENTRY_SIZE; byte++ )
-	{
-		m_UnderlyingData[byte] = other.m_UnderlyingData[byte];
-	}
-
-	for ( unsigned int byte = 0; byte < FAT16_FILENAME_SIZE; byte++ )
-	{
-		m_Filename[byte] = other.m_Filename[byte];
-	}
-
-	for ( unsigned int byte = 0; byte < FAT16_EXTENSION_SIZE; byte++ )
-	{
-		m_Extension[byte] = other.m_Extension[byte];
-	}
-
-	for ( unsigned int byte = 0; byte < FAT16_FILENAME_SIZE + FAT16_EXTENSION_SIZE + 2; byte++ ) // plus 2 for . and string terminator
-	{
-		m_FilenameWithExtension[byte] = other.m_FilenameWithExtension[byte];
-	}
-}
-
-void Fat16Entry::operator= (const Fat16Entry& other)
-{
-	for ( unsigned int byte = 0; byte < FAT16_ENTRY_SIZE; byte++ )
-	{
-		m_UnderlyingData[byte] = other.m_UnderlyingData[byte];
-	}
-
-	for ( unsigned int byte = 0; byte < FAT16_FILENAME_SIZE; byte++ )
-	{
-		m_Filename[byte] = other.m_Filename[byte];
-	}
-
-	for ( unsigned int byte = 0; byte < FAT16_EXTENSION_SIZE; byte++ )
-	{
-		m_Extension[byte] = other.m_Extension[byte];
-	}
-
-	for ( unsigned int byte = 0; byte < FAT16_FILENAME_SIZE + FAT16_EXTENSION_SIZE + 2; byte++ ) // plus 2 for . and string terminator
-	{
-		m_FilenameWithExtension[byte] = other.m_FilenameWithExtension[byte];
-	}
-
-	m_FileAttributes = other.m_FileAttributes;
-	m_TimeLastUpdated = other.m_TimeLastUpdated;
-	m_DateLastUpdated = other.m_DateLastUpdated;
-	m_StartingClusterNum = other.m_StartingClusterNum;
-	m_FileSizeInBytes = other.m_FileSizeInBytes;
-	m_IsInvalidEntry = other.m_IsInvalidEntry;
-	m_FileTransferInProgress = false;
-	m_CurrentFileSector = 0;
-	m_CurrentFileCluster = 0;
-	m_CurrentDirOffset = 0;
-	m_CurrentFileOffset = 0;
-	m_ClustersToModify.clear();
-}
-
-Fat16Entry::~Fat16Entry()
-{
-}
-
 void Fat16Entry::setToDeleted()
 {
-	m_Filename[0] = static_cast<char>( 0xE5 );
 	m_UnderlyingData[FAT16_FILENAME_OFFSET] = 0xE5;
 }
 
@@ -176,8 +70,12 @@ void Fat16Entry::setStartingClusterNum (uint16_t clusterNum)
 	uint8_t byte2 = clusterNum & 0x00FF;
 	m_UnderlyingData[FAT16_STARTING_CLUSTER_NUM_OFFSET] = byte2;
 	m_UnderlyingData[FAT16_STARTING_CLUSTER_NUM_OFFSET + 1] = byte1;
-	m_StartingClusterNum = ( m_UnderlyingData[FAT16_STARTING_CLUSTER_NUM_OFFSET + 1] << 8 )
-				| m_UnderlyingData[FAT16_STARTING_CLUSTER_NUM_OFFSET];
+}
+
+void Fat16Entry::setStartingClusterNumHigh (uint16_t clusterNumHigh)
+{
+	m_UnderlyingData[FAT16_STARTING_CLUSTER_NUM_HIGH_OFFSET] = clusterNumHigh & 0x00FF;
+	m_UnderlyingData[FAT16_STARTING_CLUSTER_NUM_HIGH_OFFSET + 1] = ( clusterNumHigh & 0xFF00 ) >> 8;
 }
 
 void Fat16Entry::setFileSizeInBytes (uint32_t fileSize)
@@ -190,10 +88,6 @@ void Fat16Entry::setFileSizeInBytes (uint32_t fileSize)
 	m_UnderlyingData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 1] = byte3;
 	m_UnderlyingData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 2] = byte2;
 	m_UnderlyingData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 3] = byte1;
-	m_FileSizeInBytes = ( m_UnderlyingData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 3] << 24 )
-				| ( m_UnderlyingData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 2] << 16 )
-				| ( m_UnderlyingData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 1] << 8 )
-				| m_UnderlyingData[FAT16_FILE_SIZE_IN_BYTES_OFFSET];
 }
 
 const uint8_t* Fat16Entry::getUnderlyingData() const
@@ -203,12 +97,12 @@ const uint8_t* Fat16Entry::getUnderlyingData() const
 
 const char* Fat16Entry::getFilenameRaw() const
 {
-	return m_Filename;
+	return reinterpret_cast<const char*>( &m_UnderlyingData[FAT16_FILENAME_OFFSET] );
 }
 
 const char* Fat16Entry::getExtensionRaw() const
 {
-	return m_Extension;
+	return reinterpret_cast<const char*>( &m_UnderlyingData[FAT16_EXTENSION_OFFSET] );
 }
 
 const char* Fat16Entry::getFilenameDisplay()
@@ -226,52 +120,64 @@ const char* Fat16Entry::getFilenameDisplay() const
 
 uint8_t Fat16Entry::getFileAttributesRaw() const
 {
-	return m_FileAttributes;
+	return m_UnderlyingData[FAT16_ATTRIBUTES_OFFSET];
 }
 
 uint16_t Fat16Entry::getTimeUpdatedRaw() const
 {
-	return m_TimeLastUpdated;
+	return ( m_UnderlyingData[FAT16_TIME_LAST_UPDATED_OFFSET + 1] << 8 ) | m_UnderlyingData[FAT16_TIME_LAST_UPDATED_OFFSET];
 }
 
 const Fat16Time Fat16Entry::getTimeUpdated() const
 {
+	const uint16_t timeLastUpdated = this->getTimeUpdatedRaw();
+
 	Fat16Time time;
-	time.hours = m_TimeLastUpdated >> 11;
-	time.minutes = ( m_TimeLastUpdated & 0b0000011111100000 ) >> 5;
-	time.twoSecondIntervals = m_TimeLastUpdated & 0b0000000000011111;
+	time.hours = timeLastUpdated >> 11;
+	time.minutes = ( timeLastUpdated & 0b0000011111100000 ) >> 5;
+	time.twoSecondIntervals = timeLastUpdated & 0b0000000000011111;
 
 	return time;
 }
 
 uint16_t Fat16Entry::getDateUpdatedRaw() const
 {
-	return m_DateLastUpdated;
+	return ( m_UnderlyingData[FAT16_DATE_LAST_UPDATED_OFFSET + 1] << 8 ) | m_UnderlyingData[FAT16_DATE_LAST_UPDATED_OFFSET];
 }
 
 const Fat16Date Fat16Entry::getDateUpdated() const
 {
+	const uint16_t dateLastUpdated = this->getDateUpdatedRaw();
+
 	Fat16Date date;
-	date.year = m_DateLastUpdated >> 9;
-	date.month = ( m_DateLastUpdated & 0b0000000111100000 ) >> 5;
-	date.day = m_DateLastUpdated & 0b0000000000011111;
+	date.year = dateLastUpdated >> 9;
+	date.month = ( dateLastUpdated & 0b0000000111100000 ) >> 5;
+	date.day = dateLastUpdated & 0b0000000000011111;
 
 	return date;
 }
 
 uint16_t Fat16Entry::getStartingClusterNum() const
 {
-	return m_StartingClusterNum;
+	return ( m_UnderlyingData[FAT16_STARTING_CLUSTER_NUM_OFFSET + 1] << 8 ) | m_UnderlyingData[FAT16_STARTING_CLUSTER_NUM_OFFSET];
+}
+
+uint16_t Fat16Entry::getStartingClusterNumHigh() const
+{
+	return ( m_UnderlyingData[FAT16_STARTING_CLUSTER_NUM_HIGH_OFFSET + 1] << 8 ) | m_UnderlyingData[FAT16_STARTING_CLUSTER_NUM_HIGH_OFFSET];
 }
 
 uint32_t Fat16Entry::getFileSizeInBytes() const
 {
-	return m_FileSizeInBytes;
+	return ( static_cast<uint32_t>(m_UnderlyingData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 3]) << 24 )
+		| ( m_UnderlyingData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 2] << 16 )
+		| ( m_UnderlyingData[FAT16_FILE_SIZE_IN_BYTES_OFFSET + 1] << 8 )
+		| m_UnderlyingData[FAT16_FILE_SIZE_IN_BYTES_OFFSET];
 }
 
 bool Fat16Entry::isUnusedEntry() const
 {
-	if ( m_Filename[0] == static_cast<char>(0x00) )
+	if ( m_UnderlyingData[FAT16_FILENAME_OFFSET] == 0x00 )
 	{
 		return true;
 	}
@@ -281,7 +187,7 @@ bool Fat16Entry::isUnusedEntry() const
 
 bool Fat16Entry::isDeletedEntry() const
 {
-	if ( m_Filename[0] == static_cast<char>(0xE5) )
+	if ( m_UnderlyingData[FAT16_FILENAME_OFFSET] == 0xE5 )
 	{
 		return true;
 	}
@@ -291,7 +197,7 @@ bool Fat16Entry::isDeletedEntry() const
 
 bool Fat16Entry::isDirectory() const
 {
-	if ( m_Filename[0] == static_cast<char>(0x2E) )
+	if ( m_UnderlyingData[FAT16_FILENAME_OFFSET] == 0x2E )
 	{
 		return true;
 	}
@@ -302,7 +208,8 @@ bool Fat16Entry::isDirectory() const
 bool Fat16Entry::isRootDirectory() const
 {
 	// TODO is this right?
-	if ( m_Filename[0] == static_cast<char>(0x2E) && m_StartingClusterNum == 0 )
+	if ( m_UnderlyingData[FAT16_FILENAME_OFFSET] == 0x2E && this->getStartingClusterNum() == 0
+			&& this->getStartingClusterNumHigh() == 0 )
 	{
 		return true;
 	}
@@ -312,7 +219,7 @@ bool Fat16Entry::isRootDirectory() const
 
 bool Fat16Entry::clusterNumIsParentDirectory() const
 {
-	if ( m_Filename[0] == static_cast<char>(0x2E) && m_Filename[1] == static_cast<char>(0x2E) )
+	if ( m_UnderlyingData[FAT16_FILENAME_OFFSET] == 0x2E && m_UnderlyingData[FAT16_FILENAME_OFFSET + 1] == 0x2E )
 	{
 		return true;
 	}
@@ -322,7 +229,7 @@ bool Fat16Entry::clusterNumIsParentDirectory() const
 
 bool Fat16Entry::isReadOnly() const
 {
-	if ( m_FileAttributes & 0x01 )
+	if ( m_UnderlyingData[FAT16_ATTRIBUTES_OFFSET] & 0x01 )
 	{
 		return true;
 	}
@@ -332,7 +239,7 @@ bool Fat16Entry::isReadOnly() const
 
 bool Fat16Entry::isHiddenEntry() const
 {
-	if ( m_FileAttributes & 0x02 )
+	if ( m_UnderlyingData[FAT16_ATTRIBUTES_OFFSET] & 0x02 )
 	{
 		return true;
 	}
@@ -342,7 +249,7 @@ bool Fat16Entry::isHiddenEntry() const
 
 bool Fat16Entry::isSystemFile() const
 {
-	if ( m_FileAttributes & 0x04 )
+	if ( m_UnderlyingData[FAT16_ATTRIBUTES_OFFSET] & 0x04 )
 	{
 		return true;
 	}
@@ -352,7 +259,7 @@ bool Fat16Entry::isSystemFile() const
 
 bool Fat16Entry::isDiskVolumeLabel() const
 {
-	if ( m_FileAttributes & 0x08 )
+	if ( m_UnderlyingData[FAT16_ATTRIBUTES_OFFSET] & 0x08 )
 	{
 		return true;
 	}
@@ -362,7 +269,7 @@ bool Fat16Entry::isDiskVolumeLabel() const
 
 bool Fat16Entry::isSubdirectory() const
 {
-	if ( m_FileAttributes & 0x10 )
+	if ( m_UnderlyingData[FAT16_ATTRIBUTES_OFFSET] & 0x10 )
 	{
 		return true;
 	}
@@ -391,7 +298,7 @@ void Fat16Entry::createFilenameDisplayString()
 		m_FilenameWithExtension[1] = '.';
 		m_FilenameWithExtension[2] = '\0';
 	}
-	else if ( m_Filename[0] == 0x05 )
+	else if ( m_UnderlyingData[FAT16_FILENAME_OFFSET] == 0x05 )
 	{
 		m_FilenameWithExtension[0] = 0xE5;
 
@@ -410,12 +317,12 @@ void Fat16Entry::createFilenameDisplayStringHelper (unsigned int startCharacter)
 		// fill the filename part
 		for ( unsigned int character = endOfFilename; character < FAT16_FILENAME_SIZE; character++ )
 		{
-			if ( m_Filename[character] == ' ' )
+			if ( m_UnderlyingData[FAT16_FILENAME_OFFSET + character] == ' ' )
 			{
 				break;
 			}
 
-			m_FilenameWithExtension[endOfFilename] = m_Filename[character];
+			m_FilenameWithExtension[endOfFilename] = m_UnderlyingData[FAT16_FILENAME_OFFSET + character];
 			endOfFilename++;
 		}
 
@@ -428,12 +335,12 @@ void Fat16Entry::createFilenameDisplayStringHelper (unsigned int startCharacter)
 			// fill the extension part
 			for ( unsigned int character = 0; character < FAT16_EXTENSION_SIZE; character++ )
 			{
-				if ( m_Extension[character] == ' ' )
+				if ( m_UnderlyingData[FAT16_EXTENSION_OFFSET + character] == ' ' )
 				{
 					break;
 				}
 
-				m_FilenameWithExtension[endOfFilename] = m_Extension[character];
+				m_FilenameWithExtension[endOfFilename] = m_UnderlyingData[FAT16_EXTENSION_OFFSET + character];
 				endOfFilename++;
 			}
 		}
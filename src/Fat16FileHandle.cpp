@@ -0,0 +1,96 @@
+#include "Fat16FileHandle.hpp"
+
+#include <utility>
+
+#include "IFatFileManager.hpp"
+#include "Fat16ReadAhead.hpp"
+
+static const uint8_t emptyEntryData[FAT16_ENTRY_SIZE] = { 0 };
+
+Fat16FileHandle::Fat16FileHandle() :
+	m_FileManager( nullptr ),
+	m_Entry( emptyEntryData ),
+	m_FileTransferInProgress( false ),
+	m_HasReadError( false ),
+	m_CurrentFileSector( 0 ),
+	m_CurrentFileCluster( 0 ),
+	m_CurrentDirOffset( 0 ),
+	m_CurrentFileOffset( 0 ),
+	m_NumBytesRead( 0 ),
+	m_ClustersToModify(),
+	m_CurrentClusterModIndex( 0 ),
+	m_NumExistingClusterMods( 0 ),
+	m_FirstClusterModNumInChain( 0 ),
+	m_DirectoryEntryNum( FAT16_NEW_DIRECTORY_ENTRY ),
+	m_WritePosition( 0 ),
+	m_SectorBuffer( SharedData<uint8_t>::MakeSharedDataNull() ),
+	m_NumBytesInSectorBuffer( 0 ),
+	m_ReadPosition( 0 ),
+	m_ClusterSkipIndex(),
+	m_ReadAhead( nullptr )
+{
+}
+
+Fat16FileHandle::Fat16FileHandle (Fat16FileHandle&& other) :
+	Fat16FileHandle()
+{
+	this->moveFrom( other );
+}
+
+Fat16FileHandle& Fat16FileHandle::operator= (Fat16FileHandle&& other)
+{
+	if ( this != &other )
+	{
+		this->close();
+		this->moveFrom( other );
+	}
+
+	return *this;
+}
+
+Fat16FileHandle::~Fat16FileHandle()
+{
+	this->close();
+
+	delete m_ReadAhead;
+}
+
+void Fat16FileHandle::close()
+{
+	if ( m_FileManager )
+	{
+		m_FileManager->closeFile( *this );
+	}
+}
+
+void Fat16FileHandle::moveFrom (Fat16FileHandle& other)
+{
+	m_FileManager = other.m_FileManager;
+	m_Entry = other.m_Entry;
+	m_FileTransferInProgress = other.m_FileTransferInProgress;
+	m_HasReadError = other.m_HasReadError;
+	m_CurrentFileSector = other.m_CurrentFileSector;
+	m_CurrentFileCluster = other.m_CurrentFileCluster;
+	m_CurrentDirOffset = other.m_CurrentDirOffset;
+	m_CurrentFileOffset = other.m_CurrentFileOffset;
+	m_NumBytesRead = other.m_NumBytesRead;
+	m_ClustersToModify = std::move( other.m_ClustersToModify );
+	m_CurrentClusterModIndex = other.m_CurrentClusterModIndex;
+	m_NumExistingClusterMods = other.m_NumExistingClusterMods;
+	m_FirstClusterModNumInChain = other.m_FirstClusterModNumInChain;
+	m_DirectoryEntryNum = other.m_DirectoryEntryNum;
+	m_WritePosition = other.m_WritePosition;
+	m_SectorBuffer = other.m_SectorBuffer;
+	m_NumBytesInSectorBuffer = other.m_NumBytesInSectorBuffer;
+	m_ReadPosition = other.m_ReadPosition;
+	m_ClusterSkipIndex = std::move( other.m_ClusterSkipIndex );
+	delete m_ReadAhead;
+	m_ReadAhead = other.m_ReadAhead;
+
+	// the moved from handle no longer owns the transfer or its reserved clusters
+	other.m_FileManager = nullptr;
+	other.m_FileTransferInProgress = false;
+	other.m_ClustersToModify.clear();
+	other.m_ClusterSkipIndex.clear();
+	other.m_ReadAhead = nullptr;
+}
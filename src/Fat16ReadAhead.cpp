@@ -0,0 +1,70 @@
+#include "Fat16ReadAhead.hpp"
+
+Fat16ReadAhead::Fat16ReadAhead (unsigned int windowSizeInSectors, unsigned int depth) :
+	m_WindowSizeInSectors( windowSizeInSectors ),
+	m_Depth( depth ),
+	m_Windows( new FatAsyncRequest[depth] ),
+	m_HeadWindow( 0 ),
+	m_NumWindows( 0 ),
+	m_HeadOffset( 0 ),
+	m_NumSequentialReads( 0 )
+{
+}
+
+Fat16ReadAhead::~Fat16ReadAhead()
+{
+	this->clear();
+
+	delete[] m_Windows;
+}
+
+bool Fat16ReadAhead::countSequentialRead()
+{
+	if ( m_NumSequentialReads < FAT16_READ_AHEAD_MIN_SEQUENTIAL_READS )
+	{
+		m_NumSequentialReads++;
+	}
+
+	return m_NumSequentialReads >= FAT16_READ_AHEAD_MIN_SEQUENTIAL_READS;
+}
+
+FatAsyncRequest& Fat16ReadAhead::pushWindow()
+{
+	FatAsyncRequest& window = m_Windows[( m_HeadWindow + m_NumWindows ) % m_Depth];
+	m_NumWindows++;
+
+	return window;
+}
+
+const SharedData<uint8_t>& Fat16ReadAhead::waitForHeadWindow()
+{
+	FatAsyncRequest& window = m_Windows[m_HeadWindow];
+	window.waitForCompletion();
+
+	return window.getData();
+}
+
+void Fat16ReadAhead::consumeHeadWindow (unsigned int numBytes)
+{
+	m_HeadOffset += numBytes;
+
+	if ( m_HeadOffset >= m_Windows[m_HeadWindow].getData().getSizeInBytes() )
+	{
+		m_HeadWindow = ( m_HeadWindow + 1 ) % m_Depth;
+		m_NumWindows--;
+		m_HeadOffset = 0;
+	}
+}
+
+void Fat16ReadAhead::clear()
+{
+	for ( unsigned int window = 0; window < m_Depth; window++ )
+	{
+		m_Windows[window].waitForCompletion();
+	}
+
+	m_HeadWindow = 0;
+	m_NumWindows = 0;
+	m_HeadOffset = 0;
+	m_NumSequentialReads = 0;
+}
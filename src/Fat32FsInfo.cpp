@@ -0,0 +1,62 @@
+#include "Fat32FsInfo.hpp"
+
+#include <string.h>
+
+Fat32FsInfo::Fat32FsInfo (const uint8_t* offset) :
+	m_UnderlyingData{ 0 }
+{
+	memcpy( m_UnderlyingData, offset, FS_INFO_SIZE_IN_BYTES );
+}
+
+bool Fat32FsInfo::signaturesAreValid() const
+{
+	if ( this->readUInt32(FS_INFO_LEAD_SIGNATURE_OFFSET) == FS_INFO_LEAD_SIGNATURE
+			&& this->readUInt32(FS_INFO_STRUCT_SIGNATURE_OFFSET) == FS_INFO_STRUCT_SIGNATURE
+			&& this->readUInt32(FS_INFO_TRAIL_SIGNATURE_OFFSET) == FS_INFO_TRAIL_SIGNATURE )
+	{
+		return true;
+	}
+
+	return false;
+}
+
+uint32_t Fat32FsInfo::getNumFreeClusters() const
+{
+	return this->readUInt32( FS_INFO_NUM_FREE_CLUSTERS_OFFSET );
+}
+
+uint32_t Fat32FsInfo::getNextFreeCluster() const
+{
+	return this->readUInt32( FS_INFO_NEXT_FREE_CLUSTER_OFFSET );
+}
+
+void Fat32FsInfo::setNumFreeClusters (uint32_t numFreeClusters)
+{
+	this->writeUInt32( FS_INFO_NUM_FREE_CLUSTERS_OFFSET, numFreeClusters );
+}
+
+void Fat32FsInfo::setNextFreeCluster (uint32_t nextFreeCluster)
+{
+	this->writeUInt32( FS_INFO_NEXT_FREE_CLUSTER_OFFSET, nextFreeCluster );
+}
+
+const uint8_t* Fat32FsInfo::getUnderlyingData() const
+{
+	return m_UnderlyingData;
+}
+
+uint32_t Fat32FsInfo::readUInt32 (unsigned int offset) const
+{
+	return ( static_cast<uint32_t>(m_UnderlyingData[offset + 3]) << 24 )
+		| ( m_UnderlyingData[offset + 2] << 16 )
+		| ( m_UnderlyingData[offset + 1] << 8 )
+		| m_UnderlyingData[offset];
+}
+
+void Fat32FsInfo::writeUInt32 (unsigned int offset, uint32_t value)
+{
+	m_UnderlyingData[offset] = value & 0x000000FF;
+	m_UnderlyingData[offset + 1] = ( value & 0x0000FF00 ) >> 8;
+	m_UnderlyingData[offset + 2] = ( value & 0x00FF0000 ) >> 16;
+	m_UnderlyingData[offset + 3] = ( value & 0xFF000000 ) >> 24;
+}
@@ -0,0 +1,47 @@
+#include "FatAsyncRequest.hpp"
+
+FatAsyncRequest::FatAsyncRequest() :
+	m_NumPendingTransfers( 0 ),
+	m_IsComplete( false ),
+	m_Data( SharedData<uint8_t>::MakeSharedDataNull() )
+{
+}
+
+void FatAsyncRequest::completeTransfer (const SharedData<uint8_t>& data)
+{
+	if ( data.getSizeInBytes() > 0 ) m_Data = data;
+
+	this->end();
+}
+
+void FatAsyncRequest::begin()
+{
+	m_IsComplete = false;
+	m_Data = SharedData<uint8_t>::MakeSharedDataNull();
+	m_NumPendingTransfers = 1;
+}
+
+void FatAsyncRequest::end()
+{
+	// Only the last transfer to finish sees the count at one. It completes the request before letting the count reach zero,
+	// so anything waiting for the request to stop pending sees it complete and can't reuse it while onComplete() is running
+	unsigned int numPendingTransfers = m_NumPendingTransfers.load();
+	while ( true )
+	{
+		if ( numPendingTransfers == 1 )
+		{
+			m_IsComplete = true;
+
+			this->onComplete();
+
+			m_NumPendingTransfers = 0;
+
+			return;
+		}
+
+		if ( m_NumPendingTransfers.compare_exchange_weak(numPendingTransfers, numPendingTransfers - 1) )
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,206 @@
+#include "FatBitmap.hpp"
+
+#include <string.h>
+
+#include "IAllocator.hpp"
+
+// strictly for allocator
+struct FAT_BITMAP_MAX
+{
+	uint32_t words[FAT_BITMAP_MAX_BITS / FAT_BITMAP_BITS_PER_WORD];
+};
+
+FatBitmap::FatBitmap (IAllocator* allocator) :
+	m_Allocator( allocator ),
+	m_Words( nullptr ),
+	m_NumBits( 0 ),
+	m_NumWords( 0 )
+{
+}
+
+FatBitmap::~FatBitmap()
+{
+	this->freeWords();
+}
+
+void FatBitmap::setNumBits (unsigned int numBits)
+{
+	this->freeWords();
+
+	if ( m_Allocator )
+	{
+		if ( numBits > FAT_BITMAP_MAX_BITS ) numBits = FAT_BITMAP_MAX_BITS;
+
+		m_Words = m_Allocator->allocate<FAT_BITMAP_MAX>()->words;
+	}
+	else
+	{
+		m_Words = new uint32_t[( numBits + FAT_BITMAP_BITS_PER_WORD - 1 ) / FAT_BITMAP_BITS_PER_WORD];
+	}
+
+	m_NumBits = numBits;
+	m_NumWords = ( numBits + FAT_BITMAP_BITS_PER_WORD - 1 ) / FAT_BITMAP_BITS_PER_WORD;
+
+	this->clearAllBits();
+}
+
+void FatBitmap::clearAllBits()
+{
+	if ( m_Words )
+	{
+		memset( m_Words, 0, m_NumWords * sizeof(uint32_t) );
+	}
+}
+
+void FatBitmap::setBits (unsigned int firstBit, const uint32_t* bits, unsigned int numBits)
+{
+	if ( firstBit >= m_NumBits ) return;
+	if ( numBits > m_NumBits - firstBit ) numBits = m_NumBits - firstBit;
+
+	// a first bit in the middle of a word spreads each word of bits across two words of the bitmap
+	const unsigned int firstWord = firstBit / FAT_BITMAP_BITS_PER_WORD;
+	const unsigned int shift = firstBit % FAT_BITMAP_BITS_PER_WORD;
+	const unsigned int numWords = ( numBits + FAT_BITMAP_BITS_PER_WORD - 1 ) / FAT_BITMAP_BITS_PER_WORD;
+	for ( unsigned int word = 0; word < numWords; word++ )
+	{
+		uint32_t wordVal = bits[word];
+		if ( word == numWords - 1 && numBits % FAT_BITMAP_BITS_PER_WORD != 0 )
+		{
+			wordVal &= ( 1u << (numBits % FAT_BITMAP_BITS_PER_WORD) ) - 1;
+		}
+
+		m_Words[firstWord + word] |= ( wordVal << shift );
+		if ( shift != 0 && firstWord + word + 1 < m_NumWords )
+		{
+			m_Words[firstWord + word + 1] |= ( wordVal >> (FAT_BITMAP_BITS_PER_WORD - shift) );
+		}
+	}
+}
+
+unsigned int FatBitmap::findNextSetBit (unsigned int startBit) const
+{
+	if ( startBit >= m_NumBits ) return m_NumBits;
+
+	// mask off the bits before the start bit in the first word, then skip empty words
+	unsigned int word = startBit / FAT_BITMAP_BITS_PER_WORD;
+	uint32_t wordVal = m_Words[word] & ( 0xFFFFFFFF << (startBit % FAT_BITMAP_BITS_PER_WORD) );
+	while ( wordVal == 0 )
+	{
+		word++;
+		if ( word >= m_NumWords ) return m_NumBits;
+
+		wordVal = m_Words[word];
+	}
+
+	const unsigned int bit = ( word * FAT_BITMAP_BITS_PER_WORD ) + __builtin_ctz( wordVal );
+
+	return ( bit < m_NumBits ) ? bit : m_NumBits;
+}
+
+unsigned int FatBitmap::findNextSetBitExcluding (unsigned int startBit, const FatBitmap& excluded) const
+{
+	if ( startBit >= m_NumBits ) return m_NumBits;
+
+	unsigned int word = startBit / FAT_BITMAP_BITS_PER_WORD;
+	uint32_t wordVal = ( m_Words[word] & ~excluded.m_Words[word] ) & ( 0xFFFFFFFF << (startBit % FAT_BITMAP_BITS_PER_WORD) );
+	while ( wordVal == 0 )
+	{
+		word++;
+		if ( word >= m_NumWords ) return m_NumBits;
+
+		wordVal = m_Words[word] & ~excluded.m_Words[word];
+	}
+
+	const unsigned int bit = ( word * FAT_BITMAP_BITS_PER_WORD ) + __builtin_ctz( wordVal );
+
+	return ( bit < m_NumBits ) ? bit : m_NumBits;
+}
+
+unsigned int FatBitmap::findNextRunOfSetBitsExcluding (unsigned int startBit, unsigned int runLength, const FatBitmap& excluded) const
+{
+	if ( runLength == 0 ) runLength = 1;
+
+	unsigned int runStart = this->findNextSetBitExcluding( startBit, excluded );
+	unsigned int bit = runStart;
+	while ( bit < m_NumBits )
+	{
+		// the set bits at the bottom of the rest of the word carry the run on, a whole word of them at a time in the middle of a run
+		const unsigned int word = bit / FAT_BITMAP_BITS_PER_WORD;
+		const unsigned int shift = bit % FAT_BITMAP_BITS_PER_WORD;
+		const uint32_t wordVal = ( m_Words[word] & ~excluded.m_Words[word] ) >> shift;
+		const unsigned int numSetBits = ( wordVal == 0xFFFFFFFF ) ? FAT_BITMAP_BITS_PER_WORD : __builtin_ctz( ~wordVal );
+
+		bit += numSetBits;
+		if ( bit - runStart >= runLength ) return runStart;
+
+		// a clear bit before the end of the word ends the run, so the next one starts at the next set bit
+		if ( numSetBits < FAT_BITMAP_BITS_PER_WORD - shift )
+		{
+			runStart = this->findNextSetBitExcluding( bit, excluded );
+			bit = runStart;
+		}
+	}
+
+	return m_NumBits;
+}
+
+unsigned int FatBitmap::findLongestRunOfSetBitsExcluding (const FatBitmap& excluded, unsigned int& runLength) const
+{
+	unsigned int longestRunStart = m_NumBits;
+	runLength = 0;
+
+	unsigned int runStart = this->findNextSetBitExcluding( 0, excluded );
+	unsigned int bit = runStart;
+	while ( bit < m_NumBits )
+	{
+		const unsigned int word = bit / FAT_BITMAP_BITS_PER_WORD;
+		const unsigned int shift = bit % FAT_BITMAP_BITS_PER_WORD;
+		const uint32_t wordVal = ( m_Words[word] & ~excluded.m_Words[word] ) >> shift;
+		const unsigned int numSetBits = ( wordVal == 0xFFFFFFFF ) ? FAT_BITMAP_BITS_PER_WORD : __builtin_ctz( ~wordVal );
+
+		bit += numSetBits;
+		if ( numSetBits < FAT_BITMAP_BITS_PER_WORD - shift || bit >= m_NumBits )
+		{
+			if ( bit - runStart > runLength )
+			{
+				longestRunStart = runStart;
+				runLength = bit - runStart;
+			}
+
+			runStart = this->findNextSetBitExcluding( bit, excluded );
+			bit = runStart;
+		}
+	}
+
+	return longestRunStart;
+}
+
+unsigned int FatBitmap::countSetBits() const
+{
+	unsigned int numSetBits = 0;
+	for ( unsigned int word = 0; word < m_NumWords; word++ )
+	{
+		numSetBits += __builtin_popcount( m_Words[word] );
+	}
+
+	return numSetBits;
+}
+
+void FatBitmap::freeWords()
+{
+	if ( m_Words )
+	{
+		if ( m_Allocator )
+		{
+			m_Allocator->free<FAT_BITMAP_MAX>( reinterpret_cast<FAT_BITMAP_MAX*>(m_Words) );
+		}
+		else
+		{
+			delete[] m_Words;
+		}
+	}
+
+	m_Words = nullptr;
+	m_NumBits = 0;
+	m_NumWords = 0;
+}
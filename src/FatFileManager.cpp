@@ -0,0 +1,2045 @@
+#include "FatFileManager.hpp"
+
+#include <algorithm>
+#include <string.h>
+
+#include "IAllocator.hpp"
+
+// what selectEntry gives back for an entry number past the end of the current directory, which reads as an unused entry
+static const uint8_t unusedEntryData[FAT16_ENTRY_SIZE] = { 0 };
+
+template <typename Traits>
+FatFileManager<Traits>::FatFileManager (IStorageMedia& storageMedia, IAllocator* fatCacheAllocator, unsigned int numFatCachePages,
+					IFatInstrumentation* instrumentation, const FatMountPolicy& mountPolicy) :
+	IFatFileManager( storageMedia ),
+	m_Allocator( fatCacheAllocator ),
+	m_NumFatCachePages( numFatCachePages ),
+	m_MountPolicy( mountPolicy ),
+	m_FatOffset( 0 ),
+	m_FatCache( m_MediaIo, fatCacheAllocator ),
+	m_RootDirectoryOffset( 0 ),
+	m_RootDirectoryCluster( 0 ),
+	m_DataOffset( 0 ),
+	m_CurrentDirOffset( 0 ),
+	m_CurrentDirectoryData( SharedData<uint8_t>::MakeSharedDataNull() ),
+	m_CurrentDirectoryIsLoaded( false ),
+	m_CurrentDirectoryDataIsShared( false ),
+	m_CurrentDirectoryClusters(),
+	m_NumCurrentDirectoryEntries( 0 ),
+	m_CurrentDirectoryEntries(),
+	m_CurrentDirectoryIndex(),
+	m_DentryCache(),
+	m_IsMounted( false ),
+	m_NumClusters( 0 ),
+	m_ClustersAreUnreachable( false ),
+	m_FreeClusterIndexIsBuilt( false ),
+	m_FreeClusters( fatCacheAllocator ),
+	m_NumFreeClusters( 0 ),
+	m_NumFreeClustersIsKnown( false ),
+	m_NextFreeClusterHint( 2 ),
+	m_FsInfo( nullptr ),
+	m_FsInfoOffset( 0 ),
+	m_FatWritePolicy( FatWritePolicy::WRITE_THROUGH ),
+	m_PendingClustersToModify( fatCacheAllocator ),
+	m_FatLock( nullptr ),
+	m_DirectoryLock( nullptr )
+{
+	this->setInstrumentation( instrumentation );
+
+	if ( IFatFileManager::isValidFatFileSystem() )
+	{
+		const uint32_t mountStartTimestamp = ( instrumentation ) ? instrumentation->getTimestamp() : 0;
+
+		m_IsMounted = this->mount();
+
+		if ( instrumentation && m_IsMounted )
+		{
+			instrumentation->onMount( mountStartTimestamp, instrumentation->getTimestamp() );
+		}
+	}
+}
+
+template <typename Traits>
+FatFileManager<Traits>::~FatFileManager()
+{
+	this->unmount();
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::isValidFatFileSystem()
+{
+	return m_IsMounted;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::mount()
+{
+	unsigned int partitionOffset = 0;
+	if ( ! m_PartitionTables.empty() )
+	{
+		partitionOffset = m_PartitionTables.at( m_ActivePartitionNum ).getOffsetLBA();
+	}
+
+	// the offsets are worked out wider than the storage media takes, so a volume that starts too far in is refused rather
+	// than wrapping around to the start of the storage media
+	const uint64_t sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	const uint64_t fatOffset = ( static_cast<uint64_t>(partitionOffset) + m_ActiveBootSector->getNumReservedSectors() ) * sectorSize;
+	const uint64_t rootDirectoryOffset = fatOffset + ( static_cast<uint64_t>(m_ActiveBootSector->getNumFats())
+								* m_ActiveBootSector->getNumSectorsPerFat() * sectorSize );
+	const uint64_t dataOffset = rootDirectoryOffset + ( m_ActiveBootSector->getNumDirectoryEntriesInRoot() * FAT16_ENTRY_SIZE );
+	const uint64_t clusterSizeInBytes = m_ActiveBootSector->getNumSectorsPerCluster() * sectorSize;
+	if ( clusterSizeInBytes == 0 || dataOffset + clusterSizeInBytes > FAT_MEDIA_OFFSET_LIMIT ) return false;
+
+	m_FatOffset = static_cast<unsigned int>( fatOffset );
+	m_RootDirectoryOffset = static_cast<unsigned int>( rootDirectoryOffset );
+	m_DataOffset = static_cast<unsigned int>( dataOffset );
+
+	const unsigned int numClustersOnVolume = this->calculateNumClusters();
+	if ( numClustersOnVolume < 2 || ! Traits::isFatType(*m_ActiveBootSector, numClustersOnVolume - 2) ) return false;
+
+	// clusters past 4GB are left out for both reading and writing, as if the volume ended there
+	m_NumClusters = std::min( numClustersOnVolume, this->calculateNumReachableClusters() );
+	m_ClustersAreUnreachable = ( m_NumClusters < numClustersOnVolume );
+
+	// without a fixed root directory region the data region starts right after the FATs, and the root directory is in it
+	if ( ! Traits::HAS_FIXED_ROOT_DIRECTORY )
+	{
+		m_RootDirectoryCluster = Traits::getRootDirectoryCluster( *m_ActiveBootSector );
+		if ( m_RootDirectoryCluster < 2 || m_RootDirectoryCluster >= m_NumClusters ) return false;
+
+		m_RootDirectoryOffset = this->getClusterOffset( m_RootDirectoryCluster );
+	}
+	m_CurrentDirOffset = m_RootDirectoryOffset;
+
+	m_FatCache.init( m_FatOffset, m_ActiveBootSector->getSectorSizeInBytes(), m_ActiveBootSector->getNumSectorsPerFat(),
+				m_ActiveBootSector->getNumFats(), m_NumFatCachePages );
+
+	if ( Traits::HAS_FS_INFO )
+	{
+		this->loadFsInfo( partitionOffset );
+	}
+
+	// when mounting lazily, the FAT sectors, root directory entries and free cluster index are loaded on first use instead.
+	// A free cluster count from the FSInfo sector saves scanning the FAT, so the index is left until something is written
+	if ( m_MountPolicy == FatMountPolicy::EAGER )
+	{
+		this->loadCurrentDirectory( 0 );
+
+		if ( ! m_NumFreeClustersIsKnown )
+		{
+			this->buildFreeClusterIndex();
+		}
+	}
+
+	return true;
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::unmount()
+{
+	// the FSInfo sector only goes out once the FAT it describes has
+	m_FatCache.flush();
+	this->writeFsInfoIfChanged();
+
+	m_IsMounted = false;
+
+	this->freeDirectoryEntriesInVecAndClear( m_CurrentDirectoryEntries );
+	m_CurrentDirectoryData = SharedData<uint8_t>::MakeSharedDataNull();
+	m_CurrentDirectoryIsLoaded = false;
+	m_CurrentDirectoryDataIsShared = false;
+	m_CurrentDirectoryClusters.clear();
+	m_NumCurrentDirectoryEntries = 0;
+	m_CurrentDirectoryIndex.clear();
+	m_DentryCache.clear();
+
+	m_RootDirectoryCluster = 0;
+	m_NumClusters = 0;
+	m_ClustersAreUnreachable = false;
+	m_FreeClusterIndexIsBuilt = false;
+	m_NumFreeClusters = 0;
+	m_NumFreeClustersIsKnown = false;
+	m_NextFreeClusterHint = 2;
+
+	if ( m_Allocator && m_FsInfo )
+	{
+		m_Allocator->free<Fat32FsInfo>( m_FsInfo );
+	}
+	else
+	{
+		delete m_FsInfo;
+	}
+	m_FsInfo = nullptr;
+	m_FsInfoOffset = 0;
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::returnToRoot()
+{
+	FatLockGuard directoryGuard( m_DirectoryLock );
+
+	this->loadCurrentDirectory( 0 );
+}
+
+template <typename Traits>
+Fat16Entry FatFileManager<Traits>::selectEntry (unsigned int entryNum)
+{
+	FatLockGuard directoryGuard( m_DirectoryLock );
+
+	this->loadCurrentDirectoryIfDeferred();
+
+	if ( entryNum >= m_NumCurrentDirectoryEntries ) return Fat16Entry( unusedEntryData );
+
+	Fat16Entry entry( &m_CurrentDirectoryData[entryNum * FAT16_ENTRY_SIZE] );
+
+	if ( entry.isRootDirectory() )
+	{
+		this->loadCurrentDirectory( 0 );
+	}
+	else if ( entry.isSubdirectory() )
+	{
+		this->loadCurrentDirectory( Traits::getStartingClusterNum( entry ) );
+	}
+
+	return entry;
+}
+
+template <typename Traits>
+std::vector<Fat16Entry*>& FatFileManager<Traits>::getCurrentDirectoryEntries()
+{
+	FatLockGuard directoryGuard( m_DirectoryLock );
+
+	this->loadCurrentDirectoryIfDeferred();
+
+	// the entry objects are only created when they are asked for, the raw directory data is what the file manager works from
+	if ( m_CurrentDirectoryEntries.size() != m_NumCurrentDirectoryEntries )
+	{
+		this->freeDirectoryEntriesInVecAndClear( m_CurrentDirectoryEntries );
+		this->writeDirectoryEntriesToVec( m_CurrentDirectoryEntries, m_CurrentDirectoryData.getPtr(), m_NumCurrentDirectoryEntries );
+	}
+
+	return m_CurrentDirectoryEntries;
+}
+
+template <typename Traits>
+Fat16DirectoryView FatFileManager<Traits>::getCurrentDirectoryView (bool skipUnusedAndDeletedEntries)
+{
+	FatLockGuard directoryGuard( m_DirectoryLock );
+
+	this->loadCurrentDirectoryIfDeferred();
+
+	// the view reads the directory data without the lock held, so from now on the data is copied before it is changed
+	m_CurrentDirectoryDataIsShared = true;
+
+	return Fat16DirectoryView( m_CurrentDirectoryData, skipUnusedAndDeletedEntries, Traits::HAS_STARTING_CLUSTER_NUM_HIGH );
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::deleteEntry (unsigned int entryNum)
+{
+	FatLockGuard directoryGuard( m_DirectoryLock );
+
+	this->loadCurrentDirectoryIfDeferred();
+
+	if ( entryNum >= m_NumCurrentDirectoryEntries ) return false;
+
+	Fat16Entry entry( &m_CurrentDirectoryData[entryNum * FAT16_ENTRY_SIZE] );
+
+	if ( entry.isRootDirectory() ) return false;
+	else if ( entry.isSubdirectory() ) return false; // TODO eventually implement subdirectory deleting
+	else if ( entry.isDirectory() ) return false; // TODO eventually implement directory deleting
+	else if ( entry.isDeletedEntry() ) return false;
+	else if ( entry.isUnusedEntry() ) return false;
+	else if ( entry.isReadOnly() ) return false;
+	else if ( entry.isHiddenEntry() ) return false; // TODO in the future probably want to be able to delete hidden entries
+	else if ( entry.isSystemFile() ) return false;
+	else if ( entry.isDiskVolumeLabel() ) return false;
+
+	m_CurrentDirectoryIndex.remove( entry.getUnderlyingData(), entryNum );
+	m_DentryCache.remove( this->getDirectoryCluster(m_CurrentDirOffset), entry.getFilenameRaw(), entry.getExtensionRaw() );
+
+	entry.setToDeleted();
+	this->setCurrentDirectoryEntry( entryNum, entry );
+
+	FatLockGuard fatGuard( m_FatLock );
+
+	// set the cluster chain to unused
+	uint32_t cluster = Traits::getStartingClusterNum( entry );
+	while ( ! this->clusterIsEndOfChain(cluster) && cluster < m_NumClusters )
+	{
+		// look up the next cluster in the FAT, then set the previous cluster to free
+		const uint32_t prevCluster = cluster;
+		cluster = this->getNextClusterInChain( prevCluster );
+		this->setClusterValue( prevCluster, Traits::FREE_CLUSTER );
+	}
+
+	this->writeEntryToStorageMedia( entry, this->getDirectoryEntryOffset(m_CurrentDirectoryClusters, entryNum) );
+
+	if ( m_FatWritePolicy == FatWritePolicy::WRITE_THROUGH )
+	{
+		m_FatCache.flush();
+	}
+
+	return true;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::findEntry (const std::string& filename, const std::string& extension, unsigned int& entryNum)
+{
+	char filenameRaw[FAT16_FILENAME_SIZE];
+	char extensionRaw[FAT16_EXTENSION_SIZE];
+	if ( ! FatFileManager::makeRawName(filename, extension, filenameRaw, extensionRaw) ) return false;
+
+	FatLockGuard directoryGuard( m_DirectoryLock );
+
+	this->loadCurrentDirectoryIfDeferred();
+
+	if ( m_NumCurrentDirectoryEntries == 0 ) return false;
+
+	entryNum = m_CurrentDirectoryIndex.find( filenameRaw, extensionRaw, &m_CurrentDirectoryData[0], m_NumCurrentDirectoryEntries );
+
+	return ( entryNum != FAT16_DIRECTORY_INDEX_NOT_FOUND );
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::resolvePath (const std::string& path, Fat16Entry& entry)
+{
+	FatLockGuard directoryGuard( m_DirectoryLock );
+
+	uint32_t dirCluster = 0;
+	uint8_t entryData[FAT16_ENTRY_SIZE];
+	bool foundEntry = false;
+
+	size_t componentStart = 0;
+	while ( componentStart <= path.size() )
+	{
+		size_t componentEnd = path.find( '/', componentStart );
+		if ( componentEnd == std::string::npos ) componentEnd = path.size();
+
+		const std::string component = path.substr( componentStart, componentEnd - componentStart );
+		componentStart = componentEnd + 1;
+
+		if ( component.empty() ) continue;
+
+		// every component before the last one needs to be a subdirectory
+		if ( foundEntry )
+		{
+			const Fat16Entry parentEntry( entryData );
+			if ( ! parentEntry.isSubdirectory() ) return false;
+
+			dirCluster = Traits::getStartingClusterNum( parentEntry );
+		}
+
+		// split the component into a filename and extension, except for the . and .. entries
+		char filenameRaw[FAT16_FILENAME_SIZE];
+		char extensionRaw[FAT16_EXTENSION_SIZE];
+		const size_t extensionStart = component.rfind( '.' );
+		if ( component == "." || component == ".." || extensionStart == std::string::npos )
+		{
+			if ( ! FatFileManager::makeRawName(component, "", filenameRaw, extensionRaw) ) return false;
+		}
+		else if ( ! FatFileManager::makeRawName(component.substr(0, extensionStart), component.substr(extensionStart + 1),
+								filenameRaw, extensionRaw) )
+		{
+			return false;
+		}
+
+		const uint8_t* cachedEntryData = m_DentryCache.find( dirCluster, filenameRaw, extensionRaw );
+		if ( cachedEntryData )
+		{
+			memcpy( entryData, cachedEntryData, FAT16_ENTRY_SIZE );
+		}
+		else if ( this->findEntryInDirectory(dirCluster, filenameRaw, extensionRaw, entryData) )
+		{
+			m_DentryCache.insert( dirCluster, entryData );
+		}
+		else
+		{
+			return false;
+		}
+
+		foundEntry = true;
+	}
+
+	if ( ! foundEntry ) return false;
+
+	entry = Fat16Entry( entryData );
+
+	return true;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::readEntry (const Fat16Entry& entry, Fat16FileHandle& handle)
+{
+	this->closeFile( handle );
+
+	// a file that starts past the clusters that can be reached can't be read at all
+	const uint32_t startingCluster = Traits::getStartingClusterNum( entry );
+	if ( FatFileManager::isReadableFile(entry) && (entry.getFileSizeInBytes() == 0 || (startingCluster >= 2 && startingCluster < m_NumClusters)) )
+	{
+		FatLockGuard directoryGuard( m_DirectoryLock, FatLockMode::SHARED );
+
+		handle.m_FileManager = this;
+		handle.m_Entry = entry;
+		handle.m_ClusterSkipIndex.clear();
+		handle.m_FileTransferInProgress = true;
+		handle.m_CurrentFileSector = 0;
+		handle.m_CurrentFileCluster = startingCluster;
+		handle.m_CurrentDirOffset = m_CurrentDirOffset;
+		handle.m_NumBytesInSectorBuffer = 0;
+		handle.m_ReadPosition = 0;
+
+		// move offset to first cluster of the file
+		handle.m_CurrentFileOffset = this->getClusterOffset( handle.m_CurrentFileCluster );
+
+		return true;
+	}
+
+	return false;
+}
+
+template <typename Traits>
+SharedData<uint8_t> FatFileManager<Traits>::getSelectedFileNextSector (Fat16FileHandle& handle)
+{
+	return this->getSelectedFileNextSectors( handle, 1 );
+}
+
+template <typename Traits>
+SharedData<uint8_t> FatFileManager<Traits>::getSelectedFileNextSectors (Fat16FileHandle& handle, unsigned int maxNumSectors)
+{
+	if ( handle.m_ReadAhead && maxNumSectors > 0 && handle.m_ReadAhead->countSequentialRead() )
+	{
+		return this->readThroughReadAhead( handle, maxNumSectors );
+	}
+
+	return this->readNextRun( handle, maxNumSectors );
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::setReadAhead (Fat16FileHandle& handle, unsigned int windowSizeInSectors, unsigned int depth)
+{
+	delete handle.m_ReadAhead;
+	handle.m_ReadAhead = nullptr;
+
+	if ( windowSizeInSectors == 0 || depth == 0 ) return false;
+
+	handle.m_ReadAhead = new Fat16ReadAhead( windowSizeInSectors, depth );
+
+	return true;
+}
+
+template <typename Traits>
+SharedData<uint8_t> FatFileManager<Traits>::readThroughReadAhead (Fat16FileHandle& handle, unsigned int maxNumSectors)
+{
+	Fat16ReadAhead& readAhead = *handle.m_ReadAhead;
+
+	// the handle's cursor runs ahead of what has been handed out, at the end of the windows already queued
+	this->fillReadAhead( handle );
+	if ( readAhead.isEmpty() ) return SharedData<uint8_t>::MakeSharedDataNull();
+
+	const SharedData<uint8_t>& window = readAhead.waitForHeadWindow();
+	const unsigned int headOffset = readAhead.getHeadOffset();
+
+	// a window the storage media couldn't read comes back empty, and the windows after it mustn't be handed out in its place
+	if ( window.getSizeInBytes() <= headOffset )
+	{
+		this->failRead( handle );
+
+		return SharedData<uint8_t>::MakeSharedDataNull();
+	}
+	const unsigned int numBytes = std::min( maxNumSectors * m_ActiveBootSector->getSectorSizeInBytes(),
+							window.getSizeInBytes() - headOffset );
+
+	// a window asked for whole can be handed back as is, otherwise the part asked for is copied out
+	SharedData<uint8_t> data = window;
+	if ( headOffset != 0 || numBytes != window.getSizeInBytes() )
+	{
+		data = SharedData<uint8_t>::MakeSharedData( numBytes );
+		memcpy( data.getPtr(), &window[headOffset], numBytes );
+	}
+
+	// queue the next window as soon as one is used up, so the storage media is kept busy while this one is consumed
+	readAhead.consumeHeadWindow( numBytes );
+	this->fillReadAhead( handle );
+
+	return data;
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::fillReadAhead (Fat16FileHandle& handle)
+{
+	Fat16ReadAhead& readAhead = *handle.m_ReadAhead;
+
+	unsigned int runOffset = 0;
+	unsigned int runSizeInBytes = 0;
+	while ( ! readAhead.isFull() && this->takeNextRun(handle, readAhead.getWindowSizeInSectors(), runOffset, runSizeInBytes) )
+	{
+		FatAsyncRequest& window = readAhead.pushWindow();
+		window.begin();
+		m_MediaIo.readAsync( FatIoType::DATA_READ, runSizeInBytes, runOffset, window );
+		window.end();
+	}
+}
+
+template <typename Traits>
+SharedData<uint8_t> FatFileManager<Traits>::readNextRun (Fat16FileHandle& handle, unsigned int maxNumSectors)
+{
+	unsigned int runOffset = 0;
+	unsigned int runSizeInBytes = 0;
+	if ( ! this->takeNextRun(handle, maxNumSectors, runOffset, runSizeInBytes) )
+	{
+		return SharedData<uint8_t>::MakeSharedDataNull();
+	}
+
+	SharedData<uint8_t> data = m_MediaIo.read( FatIoType::DATA_READ, runSizeInBytes, runOffset );
+	if ( data.getSizeInBytes() == 0 )
+	{
+		this->failRead( handle );
+	}
+
+	return data;
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::failRead (Fat16FileHandle& handle)
+{
+	this->closeFile( handle );
+	handle.m_HasReadError = true;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::readNextSectorsAsync (Fat16FileHandle& handle, unsigned int maxNumSectors, FatAsyncRequest& request)
+{
+	if ( request.isPending() ) return false;
+
+	unsigned int runOffset = 0;
+	unsigned int runSizeInBytes = 0;
+	if ( ! this->takeNextRun(handle, maxNumSectors, runOffset, runSizeInBytes) ) return false;
+
+	request.begin();
+	m_MediaIo.readAsync( FatIoType::DATA_READ, runSizeInBytes, runOffset, request );
+	request.end();
+
+	return true;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::takeNextRun (Fat16FileHandle& handle, unsigned int maxNumSectors, unsigned int& runOffset,
+					unsigned int& runSizeInBytes)
+{
+	unsigned int& currentFileSector = handle.m_CurrentFileSector;
+	unsigned int& currentFileCluster = handle.m_CurrentFileCluster;
+	unsigned int& currentFileOffset = handle.m_CurrentFileOffset;
+	unsigned int& numBytesRead = handle.m_NumBytesRead;
+
+	if ( ! handle.m_FileTransferInProgress || maxNumSectors == 0 ) return false;
+
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int numSectorsPerCluster = m_ActiveBootSector->getNumSectorsPerCluster();
+	const uint32_t fileSize = handle.m_Entry.getFileSizeInBytes();
+
+	// don't read past the last sector of the file, even if the cluster chain is longer
+	const unsigned int numSectorsInFile = ( fileSize + sectorSize - 1 ) / sectorSize;
+	const unsigned int numSectorsRead = numBytesRead / sectorSize;
+	if ( numSectorsRead >= numSectorsInFile )
+	{
+		this->endFileTransfer( handle );
+
+		return false;
+	}
+	const unsigned int maxNumSectorsInRun = std::min( maxNumSectors, numSectorsInFile - numSectorsRead );
+
+	// gather sectors into a single run for as long as the next cluster in the chain directly follows the current one
+	runOffset = currentFileOffset;
+	unsigned int numSectorsInRun = 0;
+	bool reachedEndOfChain = false;
+	while ( numSectorsInRun < maxNumSectorsInRun )
+	{
+		unsigned int numSectorsToTake = std::min( numSectorsPerCluster - currentFileSector, maxNumSectorsInRun - numSectorsInRun );
+		numSectorsInRun += numSectorsToTake;
+		currentFileSector += numSectorsToTake;
+
+		if ( currentFileSector < numSectorsPerCluster ) break;
+
+		currentFileSector = 0;
+
+		const uint32_t nextCluster = this->lockAndGetNextClusterInChain( currentFileCluster );
+		const bool nextClusterIsAdjacent = ( nextCluster == currentFileCluster + 1 );
+		currentFileCluster = nextCluster;
+
+		if ( this->clusterIsEndOfChain(nextCluster) || nextCluster >= m_NumClusters )
+		{
+			reachedEndOfChain = true;
+
+			break;
+		}
+
+		if ( ! nextClusterIsAdjacent ) break;
+	}
+
+	numBytesRead += numSectorsInRun * sectorSize;
+
+	if ( reachedEndOfChain || numBytesRead >= fileSize )
+	{
+		this->endFileTransfer( handle );
+	}
+	else
+	{
+		currentFileOffset = this->getClusterOffset( currentFileCluster ) + ( currentFileSector * sectorSize );
+	}
+
+	runSizeInBytes = numSectorsInRun * sectorSize;
+
+	return true;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::seek (Fat16FileHandle& handle, uint32_t offset)
+{
+	// only read handles can be seeked, and they keep their entry after reaching the end of the file
+	if ( ! handle.m_ClustersToModify.empty() ) return false;
+	if ( ! FatFileManager::isReadableFile(handle.m_Entry) ) return false;
+
+	const uint32_t fileSize = handle.m_Entry.getFileSizeInBytes();
+	if ( offset > fileSize ) return false;
+
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int numSectorsPerCluster = m_ActiveBootSector->getNumSectorsPerCluster();
+	const unsigned int sectorNum = offset / sectorSize;
+	const unsigned int numSectorsInFile = ( fileSize + sectorSize - 1 ) / sectorSize;
+
+	// anything read ahead was for the old position
+	if ( handle.m_ReadAhead ) handle.m_ReadAhead->clear();
+
+	handle.m_FileManager = this;
+	handle.m_FileTransferInProgress = true;
+	handle.m_HasReadError = false;
+	handle.m_NumBytesInSectorBuffer = 0;
+	handle.m_ReadPosition = offset;
+
+	// seeking to the end of the file leaves nothing left to read, and there may not be a cluster there
+	if ( sectorNum >= numSectorsInFile )
+	{
+		handle.m_NumBytesRead = numSectorsInFile * sectorSize;
+
+		return true;
+	}
+
+	uint32_t cluster = 0;
+	if ( ! this->findClusterInChain(handle, sectorNum / numSectorsPerCluster, cluster) )
+	{
+		this->closeFile( handle );
+
+		return false;
+	}
+
+	handle.m_CurrentFileCluster = cluster;
+	handle.m_CurrentFileSector = sectorNum % numSectorsPerCluster;
+	handle.m_CurrentFileOffset = this->getClusterOffset( cluster ) + ( handle.m_CurrentFileSector * sectorSize );
+	handle.m_NumBytesRead = sectorNum * sectorSize;
+
+	return true;
+}
+
+template <typename Traits>
+unsigned int FatFileManager<Traits>::read (Fat16FileHandle& handle, uint8_t* data, unsigned int numBytes)
+{
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	const uint32_t fileSize = handle.m_Entry.getFileSizeInBytes();
+
+	if ( handle.m_ReadPosition >= fileSize ) return 0;
+	numBytes = std::min( numBytes, fileSize - handle.m_ReadPosition );
+
+	// start with whatever was left over from the last sector of the previous read
+	unsigned int numBytesCopied = std::min( numBytes, handle.m_NumBytesInSectorBuffer );
+	if ( numBytesCopied > 0 )
+	{
+		memcpy( data, &handle.m_SectorBuffer[sectorSize - handle.m_NumBytesInSectorBuffer], numBytesCopied );
+		handle.m_NumBytesInSectorBuffer -= numBytesCopied;
+		handle.m_ReadPosition += numBytesCopied;
+	}
+
+	while ( numBytesCopied < numBytes )
+	{
+		// only nonzero after seeking into the middle of a sector
+		const unsigned int offsetInSector = handle.m_ReadPosition % sectorSize;
+		const unsigned int numSectorsLeft = ( offsetInSector + (numBytes - numBytesCopied) + sectorSize - 1 ) / sectorSize;
+
+		const SharedData<uint8_t> run = this->getSelectedFileNextSectors( handle, numSectorsLeft );
+		if ( run.getSizeInBytes() <= offsetInSector ) break;
+
+		const unsigned int numBytesToCopy = std::min( run.getSizeInBytes() - offsetInSector, numBytes - numBytesCopied );
+		memcpy( data + numBytesCopied, &run[offsetInSector], numBytesToCopy );
+		numBytesCopied += numBytesToCopy;
+		handle.m_ReadPosition += numBytesToCopy;
+
+		// keep the rest of a sector that was only partly taken, rather than reading it again next time
+		const unsigned int numBytesLeftInRun = run.getSizeInBytes() - offsetInSector - numBytesToCopy;
+		if ( numBytesLeftInRun > 0 )
+		{
+			if ( handle.m_SectorBuffer.getSizeInBytes() != sectorSize )
+			{
+				handle.m_SectorBuffer = SharedData<uint8_t>::MakeSharedData( sectorSize );
+			}
+
+			memcpy( &handle.m_SectorBuffer[sectorSize - numBytesLeftInRun], &run[run.getSizeInBytes() - numBytesLeftInRun], numBytesLeftInRun );
+			handle.m_NumBytesInSectorBuffer = numBytesLeftInRun;
+		}
+	}
+
+	return numBytesCopied;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::readAt (Fat16FileHandle& handle, uint32_t offset, unsigned int numBytes, SharedData<uint8_t>& data)
+{
+	data = SharedData<uint8_t>::MakeSharedDataNull();
+
+	if ( ! this->seek(handle, offset) )
+	{
+		return false;
+	}
+
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int offsetInSector = offset % sectorSize;
+
+	numBytes = std::min( numBytes, handle.m_Entry.getFileSizeInBytes() - offset );
+	const unsigned int numSectorsToRead = ( offsetInSector + numBytes + sectorSize - 1 ) / sectorSize;
+
+	// there is nothing to read at the end of the file, which isn't a failure
+	if ( numBytes == 0 )
+	{
+		return true;
+	}
+
+	// the first run can be handed back as is if it holds exactly the data asked for
+	SharedData<uint8_t> run = this->readNextRun( handle, numSectorsToRead );
+	if ( offsetInSector == 0 && run.getSizeInBytes() == numBytes )
+	{
+		data = run;
+
+		return true;
+	}
+
+	SharedData<uint8_t> readData = SharedData<uint8_t>::MakeSharedData( numBytes );
+	uint8_t* dataPtr = readData.getPtr();
+	unsigned int numBytesCopied = 0;
+	unsigned int runOffset = offsetInSector;
+	while ( numBytesCopied < numBytes )
+	{
+		// the cluster chain ended early or the storage media couldn't be read
+		if ( run.getSizeInBytes() <= runOffset )
+		{
+			return false;
+		}
+
+		const unsigned int numBytesToCopy = std::min( run.getSizeInBytes() - runOffset, numBytes - numBytesCopied );
+		memcpy( dataPtr + numBytesCopied, &run[runOffset], numBytesToCopy );
+		numBytesCopied += numBytesToCopy;
+		runOffset = 0;
+
+		if ( numBytesCopied < numBytes )
+		{
+			const unsigned int numSectorsCopied = ( offsetInSector + numBytesCopied ) / sectorSize;
+			run = this->readNextRun( handle, numSectorsToRead - numSectorsCopied );
+		}
+	}
+
+	data = readData;
+
+	return true;
+}
+
+template <typename Traits>
+unsigned int FatFileManager<Traits>::getNumFreeClusters()
+{
+	FatLockGuard fatGuard( m_FatLock );
+
+	if ( ! m_NumFreeClustersIsKnown )
+	{
+		this->buildFreeClusterIndex();
+	}
+
+	return m_NumFreeClusters;
+}
+
+template <typename Traits>
+uint64_t FatFileManager<Traits>::getFreeSpaceInBytes()
+{
+	return static_cast<uint64_t>( this->getNumFreeClusters() ) * m_ActiveBootSector->getNumSectorsPerCluster()
+		* m_ActiveBootSector->getSectorSizeInBytes();
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::setFatWritePolicy (const FatWritePolicy& policy)
+{
+	{
+		FatLockGuard fatGuard( m_FatLock );
+
+		m_FatWritePolicy = policy;
+	}
+
+	// anything left over from write back mode needs to go out now
+	if ( m_FatWritePolicy == FatWritePolicy::WRITE_THROUGH )
+	{
+		this->sync();
+	}
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::sync()
+{
+	FatLockGuard fatGuard( m_FatLock );
+
+	m_FatCache.flush();
+
+	// the FSInfo sector only goes out once the FAT it describes has
+	this->writeFsInfoIfChanged();
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::setLocks (IFatLock* fatLock, IFatLock* directoryLock, IFatLock* ioStatsLock)
+{
+	m_FatLock = fatLock;
+	m_DirectoryLock = directoryLock;
+	m_MediaIo.setStatsLock( ioStatsLock );
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::changePartition (unsigned int partitionNum)
+{
+	if ( ! m_PartitionTables.empty() )
+	{
+		FatLockGuard directoryGuard( m_DirectoryLock );
+		FatLockGuard fatGuard( m_FatLock );
+
+		this->unmount();
+
+		IFatFileManager::changePartition( partitionNum );
+
+		if ( IFatFileManager::isValidFatFileSystem() )
+		{
+			m_IsMounted = this->mount();
+		}
+	}
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::createEntry (const Fat16Entry& entry, Fat16FileHandle& handle, uint32_t expectedSizeInBytes)
+{
+	this->closeFile( handle );
+
+	FatLockGuard directoryGuard( m_DirectoryLock, FatLockMode::SHARED );
+	FatLockGuard fatGuard( m_FatLock );
+
+	// writing always leaves one more cluster reserved than the data fills, since a new one is reserved when the last sector of
+	// a cluster is filled
+	const unsigned int clusterSize = m_ActiveBootSector->getSectorSizeInBytes() * m_ActiveBootSector->getNumSectorsPerCluster();
+	const unsigned int numClustersToReserve = ( expectedSizeInBytes / clusterSize ) + 1;
+	if ( ! this->reserveClusterRuns(handle.m_ClustersToModify, numClustersToReserve) ) return false;
+
+	const uint32_t clusterNum = handle.m_ClustersToModify.front().clusterNum;
+
+	// set initial handle values
+	handle.m_FileManager = this;
+	handle.m_CurrentClusterModIndex = 0;
+	handle.m_NumExistingClusterMods = 0;
+	handle.m_FirstClusterModNumInChain = 0;
+	handle.m_DirectoryEntryNum = FAT16_NEW_DIRECTORY_ENTRY;
+	handle.m_WritePosition = 0;
+	handle.m_NumBytesInSectorBuffer = 0;
+	handle.m_Entry = entry;
+	handle.m_ClusterSkipIndex.clear();
+	handle.m_FileTransferInProgress = true;
+	handle.m_CurrentFileSector = 0;
+	handle.m_CurrentFileCluster = clusterNum;
+	handle.m_CurrentDirOffset = m_CurrentDirOffset;
+	handle.m_CurrentFileOffset = this->getClusterOffset( clusterNum );
+	Traits::setStartingClusterNum( handle.m_Entry, clusterNum );
+	handle.m_Entry.setFileSizeInBytes( 0 );
+
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	if ( handle.m_SectorBuffer.getSizeInBytes() != sectorSize )
+	{
+		handle.m_SectorBuffer = SharedData<uint8_t>::MakeSharedData( sectorSize );
+	}
+
+	return true;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::openForWrite (unsigned int entryNum, Fat16FileHandle& handle, uint32_t offset)
+{
+	this->closeFile( handle );
+
+	FatLockGuard directoryGuard( m_DirectoryLock );
+
+	this->loadCurrentDirectoryIfDeferred();
+
+	if ( entryNum >= m_NumCurrentDirectoryEntries ) return false;
+
+	const Fat16Entry entry( &m_CurrentDirectoryData[entryNum * FAT16_ENTRY_SIZE] );
+	if ( ! FatFileManager::isReadableFile(entry) || entry.isReadOnly() ) return false;
+
+	const uint32_t fileSize = entry.getFileSizeInBytes();
+	if ( offset > fileSize ) return false;
+
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int clusterSize = sectorSize * m_ActiveBootSector->getNumSectorsPerCluster();
+
+	handle.m_Entry = entry;
+	handle.m_ClusterSkipIndex.clear();
+
+	// find the cluster the offset is in, unless the file is empty and has no chain. At the end of a file that fills its last
+	// cluster there isn't one, so the last cluster is found instead and a new one is added after it
+	uint32_t cluster = Traits::FREE_CLUSTER;
+	bool offsetIsPastChain = false;
+	if ( Traits::getStartingClusterNum(entry) != 0 && ! this->findClusterInChain(handle, offset / clusterSize, cluster) )
+	{
+		if ( offset != fileSize || offset == 0 || offset % clusterSize != 0
+				|| ! this->findClusterInChain(handle, (offset / clusterSize) - 1, cluster) )
+		{
+			return false;
+		}
+
+		offsetIsPastChain = true;
+	}
+
+	std::vector<Fat16ClusterMod>& clusterModVec = handle.m_ClustersToModify;
+	{
+		FatLockGuard fatGuard( m_FatLock );
+
+		// the rest of the existing chain is written over first, with each cluster left pointing where it already does
+		while ( cluster != Traits::FREE_CLUSTER )
+		{
+			const uint32_t nextCluster = this->getNextClusterInChain( cluster );
+			Fat16ClusterMod clusterMod = { cluster, nextCluster };
+			clusterModVec.push_back( clusterMod );
+
+			cluster = ( this->clusterIsEndOfChain(nextCluster) || nextCluster >= m_NumClusters ) ? Traits::FREE_CLUSTER : nextCluster;
+		}
+
+		handle.m_NumExistingClusterMods = clusterModVec.size();
+
+		if ( ( clusterModVec.empty() || offsetIsPastChain ) && ! this->reserveClusterRuns(clusterModVec, 1) )
+		{
+			clusterModVec.clear();
+			handle.m_NumExistingClusterMods = 0;
+
+			return false;
+		}
+	}
+
+	// an empty file starts at the cluster just reserved
+	if ( handle.m_NumExistingClusterMods == 0 )
+	{
+		Traits::setStartingClusterNum( handle.m_Entry, clusterModVec.front().clusterNum );
+	}
+
+	handle.m_FileManager = this;
+	handle.m_CurrentClusterModIndex = ( offsetIsPastChain ) ? 1 : 0;
+	handle.m_FirstClusterModNumInChain = ( offset / clusterSize ) - handle.m_CurrentClusterModIndex;
+	handle.m_DirectoryEntryNum = entryNum;
+	handle.m_WritePosition = offset;
+	handle.m_FileTransferInProgress = true;
+	handle.m_CurrentFileSector = ( offsetIsPastChain ) ? 0 : ( offset % clusterSize ) / sectorSize;
+	handle.m_CurrentFileCluster = clusterModVec[handle.m_CurrentClusterModIndex].clusterNum;
+	handle.m_CurrentDirOffset = m_CurrentDirOffset;
+	handle.m_CurrentFileOffset = this->getClusterOffset( handle.m_CurrentFileCluster ) + ( handle.m_CurrentFileSector * sectorSize );
+
+	if ( handle.m_SectorBuffer.getSizeInBytes() != sectorSize )
+	{
+		handle.m_SectorBuffer = SharedData<uint8_t>::MakeSharedData( sectorSize );
+	}
+
+	// the start of a sector the offset is part way through is kept, so the first write can put it back
+	handle.m_NumBytesInSectorBuffer = offset % sectorSize;
+	if ( handle.m_NumBytesInSectorBuffer > 0 )
+	{
+		SharedData<uint8_t> sectorData = m_MediaIo.read( FatIoType::DATA_READ, sectorSize, handle.m_CurrentFileOffset );
+		memcpy( handle.m_SectorBuffer.getPtr(), sectorData.getPtr(), handle.m_NumBytesInSectorBuffer );
+	}
+
+	return true;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::openForAppend (unsigned int entryNum, Fat16FileHandle& handle)
+{
+	uint32_t fileSize = 0;
+	{
+		FatLockGuard directoryGuard( m_DirectoryLock );
+
+		this->loadCurrentDirectoryIfDeferred();
+
+		if ( entryNum >= m_NumCurrentDirectoryEntries ) return false;
+
+		fileSize = Fat16Entry( &m_CurrentDirectoryData[entryNum * FAT16_ENTRY_SIZE] ).getFileSizeInBytes();
+	}
+
+	return this->openForWrite( entryNum, handle, fileSize );
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::writeToEntry (Fat16FileHandle& handle, const SharedData<uint8_t>& data)
+{
+	return this->writeToEntry( handle, data, false, nullptr );
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::flushToEntry (Fat16FileHandle& handle, const SharedData<uint8_t>& data)
+{
+	return this->writeToEntry( handle, data, true, nullptr ) && this->finalizeEntry( handle );
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::writeToEntryAsync (Fat16FileHandle& handle, const SharedData<uint8_t>& data, FatAsyncRequest& request)
+{
+	if ( request.isPending() ) return false;
+
+	// runs already queued still complete the request if the write fails part way through
+	request.begin();
+	const bool wroteData = this->writeToEntry( handle, data, false, &request );
+	request.end();
+
+	return wroteData;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::writeToEntry (Fat16FileHandle& handle, const SharedData<uint8_t>& data, bool allowPartialSector,
+						FatAsyncRequest* request)
+{
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int numSectorsPerCluster = m_ActiveBootSector->getNumSectorsPerCluster();
+
+	unsigned int& currentFileSector = handle.m_CurrentFileSector;
+	unsigned int& currentFileCluster = handle.m_CurrentFileCluster;
+	unsigned int& currentFileOffset = handle.m_CurrentFileOffset;
+	std::vector<Fat16ClusterMod>& clusterModVec = handle.m_ClustersToModify;
+
+	// if data (after the start of a sector kept by openForWrite) doesn't fit into sector size and this isn't the last write
+	// of the file, return false
+	const unsigned int numBytesKept = ( clusterModVec.empty() || data.getSizeInBytes() == 0 ) ? 0 : handle.m_NumBytesInSectorBuffer;
+	bool dataDoesntFit = ( (numBytesKept + data.getSizeInBytes()) % sectorSize != 0 ) ? true : false;
+	if ( dataDoesntFit && ! allowPartialSector ) return false;
+
+	if ( handle.m_FileTransferInProgress && ! clusterModVec.empty() && data.getSizeInBytes() > 0 )
+	{
+		const uint32_t writeEnd = handle.m_WritePosition + data.getSizeInBytes();
+		const bool keepTail = ( dataDoesntFit && writeEnd < handle.m_Entry.getFileSizeInBytes() );
+		const SharedData<uint8_t> dataToWrite = ( numBytesKept > 0 || keepTail ) ? this->mergeWithPartialSectors( handle, data, keepTail ) : data;
+		const unsigned int totalBytesToWrite = dataToWrite.getSizeInBytes();
+
+		// reserve all the clusters this write will cross that weren't reserved by createEntry, so that runs of adjacent clusters
+		// can be written at once (a new cluster is always reserved when the last sector of a cluster is filled, so the cursor
+		// stays valid)
+		unsigned int& clusterModIndex = handle.m_CurrentClusterModIndex;
+		const unsigned int numSectorsToWrite = ( totalBytesToWrite + sectorSize - 1 ) / sectorSize;
+		const unsigned int numClustersNeeded = ( currentFileSector + numSectorsToWrite ) / numSectorsPerCluster;
+		const unsigned int numClustersReserved = clusterModVec.size() - 1 - clusterModIndex;
+		const unsigned int numClustersToReserve = ( numClustersNeeded > numClustersReserved ) ? numClustersNeeded - numClustersReserved : 0;
+
+		bool reservedClusters = true;
+		{
+			FatLockGuard fatGuard( m_FatLock );
+
+			for ( unsigned int clusterNum = 0; clusterNum < numClustersToReserve; clusterNum++ )
+			{
+				const uint32_t freeCluster = this->findFreeCluster( clusterModVec.back().clusterNum + 1 );
+
+				if ( freeCluster == Traits::FREE_CLUSTER )
+				{
+					reservedClusters = false;
+
+					break;
+				}
+
+				// set old cluster to new free cluster and new cluster to end of file
+				clusterModVec.back().clusterNewVal = freeCluster;
+				Fat16ClusterMod newClusterMod = { freeCluster, Traits::END_OF_CHAIN_CLUSTER };
+				clusterModVec.push_back( newClusterMod );
+
+				this->reserveCluster( freeCluster );
+			}
+		}
+
+		if ( ! reservedClusters )
+		{
+			this->closeFile( handle );
+
+			return false;
+		}
+
+		// write each run of physically adjacent clusters with a single write to the storage media
+		unsigned int bytesWritten = 0;
+		while ( bytesWritten < totalBytesToWrite )
+		{
+			const unsigned int runOffset = currentFileOffset;
+			unsigned int numBytesInRun = 0;
+
+			while ( bytesWritten + numBytesInRun < totalBytesToWrite )
+			{
+				const unsigned int bytesLeftInCluster = ( numSectorsPerCluster - currentFileSector ) * sectorSize;
+				const unsigned int bytesToTake = std::min( bytesLeftInCluster, totalBytesToWrite - bytesWritten - numBytesInRun );
+				numBytesInRun += bytesToTake;
+				currentFileSector += ( bytesToTake + sectorSize - 1 ) / sectorSize;
+
+				if ( currentFileSector < numSectorsPerCluster ) break;
+
+				currentFileSector = 0;
+				clusterModIndex++;
+
+				const uint32_t nextCluster = clusterModVec[clusterModIndex].clusterNum;
+				const bool nextClusterIsAdjacent = ( nextCluster == currentFileCluster + 1 );
+				currentFileCluster = nextCluster;
+
+				if ( ! nextClusterIsAdjacent ) break;
+			}
+
+			this->writeRunToStorageMedia( handle, dataToWrite, bytesWritten, numBytesInRun, runOffset, request );
+			bytesWritten += numBytesInRun;
+
+			currentFileOffset = this->getClusterOffset( currentFileCluster ) + ( currentFileSector * sectorSize );
+		}
+
+		// writing over an existing file only makes it bigger if the write goes past the end of it
+		handle.m_Entry.setFileSizeInBytes( std::max(handle.m_Entry.getFileSizeInBytes(), writeEnd) );
+		handle.m_WritePosition = writeEnd;
+		handle.m_NumBytesInSectorBuffer = 0;
+	}
+
+	return true;
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::writeRunToStorageMedia (Fat16FileHandle& handle, const SharedData<uint8_t>& data, unsigned int dataOffset,
+						unsigned int numBytes, unsigned int mediaOffset, FatAsyncRequest* request)
+{
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+
+	// if the run covers all of the data in whole sectors, it can go straight to the storage media without a copy
+	SharedData<uint8_t> runBuffer = data;
+	if ( dataOffset != 0 || numBytes != data.getSizeInBytes() || numBytes % sectorSize != 0 )
+	{
+		// otherwise the run is copied into a sector aligned buffer, with any trailing bytes of the last sector zeroed. The handle's
+		// sector buffer can't be used for an async write, since the next write could change it before this one completes
+		const unsigned int numBytesAligned = ( (numBytes + sectorSize - 1) / sectorSize ) * sectorSize;
+		runBuffer = ( numBytesAligned == sectorSize && ! request ) ? handle.m_SectorBuffer
+										: SharedData<uint8_t>::MakeSharedData( numBytesAligned );
+		uint8_t* runBufferPtr = runBuffer.getPtr();
+		memcpy( runBufferPtr, &data[dataOffset], numBytes );
+		memset( runBufferPtr + numBytes, 0, numBytesAligned - numBytes );
+	}
+
+	if ( request )
+	{
+		m_MediaIo.writeAsync( FatIoType::DATA_WRITE, runBuffer, mediaOffset, *request );
+	}
+	else
+	{
+		m_MediaIo.write( FatIoType::DATA_WRITE, runBuffer, mediaOffset );
+	}
+}
+
+template <typename Traits>
+SharedData<uint8_t> FatFileManager<Traits>::mergeWithPartialSectors (Fat16FileHandle& handle, const SharedData<uint8_t>& data, bool keepTail)
+{
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int numSectorsPerCluster = m_ActiveBootSector->getNumSectorsPerCluster();
+	const unsigned int numBytesKept = handle.m_NumBytesInSectorBuffer;
+	const unsigned int numBytes = numBytesKept + data.getSizeInBytes();
+	const unsigned int numBytesMerged = ( keepTail ) ? ( (numBytes + sectorSize - 1) / sectorSize ) * sectorSize : numBytes;
+
+	SharedData<uint8_t> mergedData = SharedData<uint8_t>::MakeSharedData( numBytesMerged );
+	uint8_t* mergedDataPtr = mergedData.getPtr();
+	memcpy( mergedDataPtr, handle.m_SectorBuffer.getPtr(), numBytesKept );
+	memcpy( mergedDataPtr + numBytesKept, &data[0], data.getSizeInBytes() );
+	memset( mergedDataPtr + numBytes, 0, numBytesMerged - numBytes );
+
+	// the file carries on past the data, so the last sector is in the part of the existing chain the handle holds
+	const unsigned int lastSector = handle.m_CurrentFileSector + ( numBytes / sectorSize );
+	const unsigned int lastClusterModIndex = handle.m_CurrentClusterModIndex + ( lastSector / numSectorsPerCluster );
+	if ( keepTail && lastClusterModIndex < handle.m_NumExistingClusterMods )
+	{
+		const uint32_t lastCluster = handle.m_ClustersToModify[lastClusterModIndex].clusterNum;
+		const unsigned int lastSectorOffset = this->getClusterOffset( lastCluster ) + ( (lastSector % numSectorsPerCluster) * sectorSize );
+		SharedData<uint8_t> lastSectorData = m_MediaIo.read( FatIoType::DATA_READ, sectorSize, lastSectorOffset );
+
+		const unsigned int numBytesInLastSector = numBytes % sectorSize;
+		memcpy( mergedDataPtr + numBytes, lastSectorData.getPtr() + numBytesInLastSector, sectorSize - numBytesInLastSector );
+	}
+
+	return mergedData;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::drainWriteBehind (Fat16FileHandle& handle, FatWriteBehindBuffer& buffer)
+{
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+
+	// a buffer that can't hold a whole sector could never be drained
+	if ( buffer.getSizeInBytes() < sectorSize ) return false;
+
+	// batches end on a cluster boundary so runs of whole clusters go out together, unless the buffer is too small to ever
+	// fill up to one while the next is being pushed
+	unsigned int batchAlignment = sectorSize * m_ActiveBootSector->getNumSectorsPerCluster();
+	while ( batchAlignment > buffer.getSizeInBytes() / 2 && batchAlignment > sectorSize )
+	{
+		batchAlignment /= 2;
+	}
+
+	// the handle is always at a sector boundary between writes, apart from the start of a sector kept by openForWrite. The
+	// first batch after opening a file part way through a batch only goes up to the next boundary, and needs a buffer of its own
+	const unsigned int offsetInBatch = ( (handle.m_CurrentFileSector * sectorSize) % batchAlignment ) + handle.m_NumBytesInSectorBuffer;
+	if ( offsetInBatch > 0 )
+	{
+		const unsigned int numBytesToBoundary = batchAlignment - offsetInBatch;
+		if ( buffer.getNumBytesQueued() < numBytesToBoundary ) return true;
+
+		SharedData<uint8_t> firstBatch = SharedData<uint8_t>::MakeSharedData( numBytesToBoundary );
+		buffer.peek( firstBatch.getPtr(), numBytesToBoundary );
+		if ( ! this->writeToEntry(handle, firstBatch) ) return false;
+		buffer.discard( numBytesToBoundary );
+	}
+
+	// every other batch is half the buffer (in whole batch alignments), so they can all be written from the same buffer. The
+	// data is only taken out of the write behind buffer once it is written, so nothing queued is lost if a write fails
+	const unsigned int batchSize = std::max( ((buffer.getSizeInBytes() / 2) / batchAlignment) * batchAlignment, batchAlignment );
+	SharedData<uint8_t>& batch = buffer.getDrainBatch( batchSize );
+	while ( buffer.getNumBytesQueued() >= batchSize )
+	{
+		buffer.peek( batch.getPtr(), batchSize );
+		if ( ! this->writeToEntry(handle, batch) ) return false;
+		buffer.discard( batchSize );
+	}
+
+	return true;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::finalizeWriteBehind (Fat16FileHandle& handle, FatWriteBehindBuffer& buffer)
+{
+	// the last of the data may end part way through a sector, and is written before finalizing so it can be taken out of the
+	// write behind buffer as soon as it is in the file
+	const unsigned int numBytesQueued = buffer.getNumBytesQueued();
+	if ( numBytesQueued > 0 )
+	{
+		SharedData<uint8_t> lastBatch = SharedData<uint8_t>::MakeSharedData( numBytesQueued );
+		buffer.peek( lastBatch.getPtr(), numBytesQueued );
+		if ( ! this->writeToEntry(handle, lastBatch, true, nullptr) ) return false;
+		buffer.discard( numBytesQueued );
+	}
+
+	return this->finalizeEntry( handle );
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::finalizeEntry (Fat16FileHandle& handle)
+{
+	// only a handle opened with createEntry or openForWrite has clusters to commit
+	if ( handle.m_ClustersToModify.empty() ) return false;
+
+	FatLockGuard directoryGuard( m_DirectoryLock );
+
+	this->loadCurrentDirectoryIfDeferred();
+
+	const Fat16Entry& entry = handle.m_Entry;
+	const unsigned int entryDirOffset = handle.m_CurrentDirOffset;
+	const uint32_t entryDirCluster = this->getDirectoryCluster( entryDirOffset );
+	const bool entryIsInCurrentDirectory = ( entryDirOffset == m_CurrentDirOffset );
+
+	// read the whole of the other directory if necessary, else just use the current directory entries
+	SharedData<uint8_t> dirData = m_CurrentDirectoryData;
+	std::vector<uint32_t> otherDirClusters;
+	std::vector<uint32_t>& dirClusters = ( entryIsInCurrentDirectory ) ? m_CurrentDirectoryClusters : otherDirClusters;
+	if ( ! entryIsInCurrentDirectory )
+	{
+		dirData = this->readDirectory( entryDirCluster, otherDirClusters );
+	}
+
+	// an existing file is written back to its own entry, as long as nothing has taken the entry's place since it was opened
+	bool foundEntryToModify = false;
+	unsigned int entryToModifyNum = 0;
+	const unsigned int numDirEntries = dirData.getSizeInBytes() / FAT16_ENTRY_SIZE;
+	const bool entryIsNew = ( handle.m_DirectoryEntryNum == FAT16_NEW_DIRECTORY_ENTRY );
+	if ( ! entryIsNew )
+	{
+		entryToModifyNum = handle.m_DirectoryEntryNum;
+		const unsigned int entryToModifyOffset = entryToModifyNum * FAT16_ENTRY_SIZE;
+		if ( entryToModifyNum >= numDirEntries
+				|| memcmp(&dirData[entryToModifyOffset + FAT16_FILENAME_OFFSET], entry.getFilenameRaw(), FAT16_FILENAME_SIZE) != 0
+				|| memcmp(&dirData[entryToModifyOffset + FAT16_EXTENSION_OFFSET], entry.getExtensionRaw(), FAT16_EXTENSION_SIZE) != 0 )
+		{
+			return false;
+		}
+
+		foundEntryToModify = true;
+	}
+
+	// find an unused entry to write the new entry to
+	for ( unsigned int entryNum = 0; entryIsNew && entryNum < numDirEntries; entryNum++ )
+	{
+		const uint8_t firstCharacter = dirData[( entryNum * FAT16_ENTRY_SIZE ) + FAT16_FILENAME_OFFSET];
+		if ( firstCharacter == 0x00 || firstCharacter == 0xE5 )
+		{
+			foundEntryToModify = true;
+			entryToModifyNum = entryNum;
+
+			break;
+		}
+	}
+
+	// a fixed root directory region can't grow, but any directory that is a cluster chain can be given another cluster
+	bool directoryGrew = false;
+	if ( ! foundEntryToModify )
+	{
+		if ( dirClusters.empty() || ! this->growDirectory(dirClusters) ) return false;
+
+		directoryGrew = true;
+		entryToModifyNum = numDirEntries;
+	}
+
+	this->writeEntryToStorageMedia( entry, this->getDirectoryEntryOffset(dirClusters, entryToModifyNum) );
+	m_DentryCache.remove( entryDirCluster, entry.getFilenameRaw(), entry.getExtensionRaw() );
+
+	// apply changes to fat
+	{
+		FatLockGuard fatGuard( m_FatLock );
+
+		// reserved clusters past the end of the file are given back, so the chain ends where the file does. That includes the
+		// one reserved when a write fills the last cluster or openForWrite starts past the end of the chain, which holds no
+		// data. An existing file's chain is kept whole, and was never reserved, so it is never cleared from the pending clusters
+		std::vector<Fat16ClusterMod>& clusterModVec = handle.m_ClustersToModify;
+		const unsigned int clusterSize = m_ActiveBootSector->getSectorSizeInBytes() * m_ActiveBootSector->getNumSectorsPerCluster();
+		const unsigned int numClustersInFile = std::max( (entry.getFileSizeInBytes() + clusterSize - 1) / clusterSize, 1u );
+		const unsigned int numClusterModsInFile = ( numClustersInFile > handle.m_FirstClusterModNumInChain )
+								? numClustersInFile - handle.m_FirstClusterModNumInChain : 1;
+		const unsigned int numClusterModsToKeep = std::max( numClusterModsInFile, handle.m_NumExistingClusterMods );
+		for ( unsigned int clusterModIndex = numClusterModsToKeep; clusterModIndex < clusterModVec.size(); clusterModIndex++ )
+		{
+			m_PendingClustersToModify.clearBit( clusterModVec[clusterModIndex].clusterNum );
+		}
+		if ( numClusterModsToKeep < clusterModVec.size() )
+		{
+			clusterModVec.resize( numClusterModsToKeep );
+			clusterModVec.back().clusterNewVal = Traits::END_OF_CHAIN_CLUSTER;
+		}
+
+		// of an existing file's chain, only the last cluster can have changed (if clusters were added after it)
+		const unsigned int firstClusterModToApply = ( handle.m_NumExistingClusterMods > 0 ) ? handle.m_NumExistingClusterMods - 1 : 0;
+		for ( unsigned int clusterModIndex = firstClusterModToApply; clusterModIndex < clusterModVec.size(); clusterModIndex++ )
+		{
+			this->setClusterValue( clusterModVec[clusterModIndex].clusterNum, clusterModVec[clusterModIndex].clusterNewVal );
+		}
+
+		if ( m_FatWritePolicy == FatWritePolicy::WRITE_THROUGH )
+		{
+			m_FatCache.flush();
+		}
+	}
+
+	// write change to cached current directory entries if file exists in the current directory
+	if ( entryIsInCurrentDirectory && directoryGrew )
+	{
+		this->loadCurrentDirectory( entryDirCluster );
+	}
+	else if ( entryIsInCurrentDirectory )
+	{
+		this->setCurrentDirectoryEntry( entryToModifyNum, entry );
+		if ( entryIsNew ) m_CurrentDirectoryIndex.insert( entry.getUnderlyingData(), entryToModifyNum );
+	}
+
+	this->closeFile( handle );
+
+	return true;
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::closeFile (Fat16FileHandle& handle)
+{
+	if ( handle.m_ReadAhead ) handle.m_ReadAhead->clear();
+
+	this->endFileTransfer( handle );
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::endFileTransfer (Fat16FileHandle& handle)
+{
+	// clear any clusters that were to be modified in the fat and end any previous write or read process
+	handle.m_FileTransferInProgress = false;
+	handle.m_HasReadError = false;
+	handle.m_CurrentFileSector = 0;
+	handle.m_CurrentFileCluster = Traits::getStartingClusterNum( handle.m_Entry );
+	handle.m_CurrentFileOffset = 0;
+	handle.m_NumBytesRead = 0;
+
+	// clear from pending clusters to modify. An existing file's chain at the start of the clusters to modify was never
+	// reserved, and may be past the end of the pending bitmap (or be read before the bitmap is built at all)
+	if ( handle.m_NumExistingClusterMods < handle.m_ClustersToModify.size() )
+	{
+		FatLockGuard fatGuard( m_FatLock );
+
+		for ( unsigned int clusterModIndex = handle.m_NumExistingClusterMods; clusterModIndex < handle.m_ClustersToModify.size();
+				clusterModIndex++ )
+		{
+			m_PendingClustersToModify.clearBit( handle.m_ClustersToModify[clusterModIndex].clusterNum );
+		}
+	}
+
+	handle.m_ClustersToModify.clear();
+	handle.m_CurrentClusterModIndex = 0;
+	handle.m_NumExistingClusterMods = 0;
+	handle.m_FirstClusterModNumInChain = 0;
+	handle.m_DirectoryEntryNum = FAT16_NEW_DIRECTORY_ENTRY;
+	handle.m_FileManager = nullptr;
+}
+
+template <typename Traits>
+uint32_t FatFileManager<Traits>::getNextClusterInChain (uint32_t cluster)
+{
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int clusterValOffset = Traits::ENTRY_SIZE_IN_BYTES * cluster;
+	const uint8_t* sectorPtr = m_FatCache.getSector( clusterValOffset / sectorSize );
+
+	return Traits::readClusterValue( &sectorPtr[clusterValOffset % sectorSize] );
+}
+
+template <typename Traits>
+uint32_t FatFileManager<Traits>::lockAndGetNextClusterInChain (uint32_t cluster)
+{
+	FatLockGuard fatGuard( m_FatLock, FatLockMode::SHARED );
+	this->upgradeFatLockIfNotResident( fatGuard );
+
+	return this->getNextClusterInChain( cluster );
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::upgradeFatLockIfNotResident (FatLockGuard& fatGuard)
+{
+	if ( ! m_FatCache.isResident() )
+	{
+		fatGuard.upgrade();
+	}
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::findClusterInChain (Fat16FileHandle& handle, unsigned int clusterIndex, uint32_t& cluster)
+{
+	std::vector<uint32_t>& skipIndex = handle.m_ClusterSkipIndex;
+	if ( skipIndex.empty() )
+	{
+		skipIndex.push_back( Traits::getStartingClusterNum( handle.m_Entry ) );
+	}
+
+	FatLockGuard fatGuard( m_FatLock, FatLockMode::SHARED );
+	this->upgradeFatLockIfNotResident( fatGuard );
+
+	// start from the closest indexed cluster at or before the one asked for
+	const unsigned int skipIndexPos = std::min( clusterIndex / FAT16_CLUSTER_SKIP_INTERVAL, static_cast<unsigned int>(skipIndex.size() - 1) );
+	unsigned int currentClusterIndex = skipIndexPos * FAT16_CLUSTER_SKIP_INTERVAL;
+	cluster = skipIndex[skipIndexPos];
+
+	while ( true )
+	{
+		if ( this->clusterIsEndOfChain(cluster) || cluster >= m_NumClusters ) return false;
+
+		// record every FAT16_CLUSTER_SKIP_INTERVAL'th cluster past the end of the index as the chain is walked
+		if ( currentClusterIndex == skipIndex.size() * FAT16_CLUSTER_SKIP_INTERVAL )
+		{
+			skipIndex.push_back( cluster );
+		}
+
+		if ( currentClusterIndex == clusterIndex ) return true;
+
+		cluster = this->getNextClusterInChain( cluster );
+		currentClusterIndex++;
+	}
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::clusterIsEndOfChain (uint32_t cluster)
+{
+	// anything from the bad cluster marker upwards is either bad or one of the end of chain markers
+	if ( cluster == Traits::FREE_CLUSTER
+			|| cluster == Traits::RESERVED_CLUSTER
+			|| cluster >= Traits::BAD_CLUSTER )
+	{
+		return true;
+	}
+
+	return false;
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::setClusterValue (uint32_t cluster, uint32_t newClusterVal)
+{
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int clusterValOffset = Traits::ENTRY_SIZE_IN_BYTES * cluster;
+	uint8_t* sectorPtr = m_FatCache.getSectorForWrite( clusterValOffset / sectorSize );
+
+	const uint32_t oldClusterVal = Traits::readClusterValue( &sectorPtr[clusterValOffset % sectorSize] );
+	Traits::writeClusterValue( &sectorPtr[clusterValOffset % sectorSize], newClusterVal );
+
+	this->updateFreeClusterIndex( cluster, oldClusterVal, newClusterVal );
+}
+
+template <typename Traits>
+uint32_t FatFileManager<Traits>::findFreeCluster (unsigned int startCluster)
+{
+	this->buildFreeClusterIndexIfDeferred();
+
+	// search from the start cluster to the end of the FAT, then wrap around to the first data cluster (first two are reserved)
+	const unsigned int numIndexedClusters = m_FreeClusters.getNumBits();
+	if ( startCluster < 2 || startCluster >= numIndexedClusters ) startCluster = 2;
+
+	unsigned int clusterNum = m_FreeClusters.findNextSetBitExcluding( startCluster, m_PendingClustersToModify );
+	if ( clusterNum < numIndexedClusters ) return clusterNum;
+
+	clusterNum = m_FreeClusters.findNextSetBitExcluding( 2, m_PendingClustersToModify );
+	if ( clusterNum < startCluster ) return clusterNum;
+
+	return Traits::FREE_CLUSTER;
+}
+
+template <typename Traits>
+uint32_t FatFileManager<Traits>::findFreeRun (unsigned int startCluster, unsigned int runLength)
+{
+	this->buildFreeClusterIndexIfDeferred();
+
+	const unsigned int numIndexedClusters = m_FreeClusters.getNumBits();
+	if ( startCluster < 2 || startCluster >= numIndexedClusters ) startCluster = 2;
+
+	unsigned int clusterNum = m_FreeClusters.findNextRunOfSetBitsExcluding( startCluster, runLength, m_PendingClustersToModify );
+	if ( clusterNum < numIndexedClusters ) return clusterNum;
+
+	// after wrapping around, a run may start before the start cluster and end past it
+	clusterNum = m_FreeClusters.findNextRunOfSetBitsExcluding( 2, runLength, m_PendingClustersToModify );
+	if ( clusterNum < startCluster ) return clusterNum;
+
+	return Traits::FREE_CLUSTER;
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::reserveCluster (uint32_t cluster)
+{
+	// add this cluster to the pending modified clusters set and move the roving hint past it
+	m_PendingClustersToModify.setBit( cluster );
+	m_NextFreeClusterHint = cluster + 1;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::reserveClusterRuns (std::vector<Fat16ClusterMod>& clusterModVec, unsigned int numClusters)
+{
+	this->buildFreeClusterIndexIfDeferred();
+
+	// the free count includes clusters other writes have reserved, so this only catches what can't possibly fit
+	if ( numClusters > m_NumFreeClusters ) return false;
+
+	const unsigned int firstNewClusterModIndex = clusterModVec.size();
+	const unsigned int nextFreeClusterHint = m_NextFreeClusterHint;
+
+	// take a run of everything still needed if there is one, else the longest run there is, which covers the clusters with as
+	// few runs as possible
+	while ( numClusters > 0 )
+	{
+		unsigned int runLength = numClusters;
+		uint32_t runStart = this->findFreeRun( m_NextFreeClusterHint, runLength );
+		if ( runStart == Traits::FREE_CLUSTER )
+		{
+			runStart = m_FreeClusters.findLongestRunOfSetBitsExcluding( m_PendingClustersToModify, runLength );
+			if ( runLength == 0 ) break;
+		}
+
+		for ( uint32_t clusterNum = runStart; clusterNum < runStart + runLength; clusterNum++ )
+		{
+			if ( ! clusterModVec.empty() ) clusterModVec.back().clusterNewVal = clusterNum;
+			Fat16ClusterMod clusterMod = { clusterNum, Traits::END_OF_CHAIN_CLUSTER };
+			clusterModVec.push_back( clusterMod );
+
+			this->reserveCluster( clusterNum );
+		}
+
+		numClusters -= runLength;
+	}
+
+	if ( numClusters == 0 ) return true;
+
+	// there isn't enough free space, so give back what was reserved
+	for ( unsigned int clusterModIndex = firstNewClusterModIndex; clusterModIndex < clusterModVec.size(); clusterModIndex++ )
+	{
+		m_PendingClustersToModify.clearBit( clusterModVec[clusterModIndex].clusterNum );
+	}
+	clusterModVec.resize( firstNewClusterModIndex );
+	if ( ! clusterModVec.empty() ) clusterModVec.back().clusterNewVal = Traits::END_OF_CHAIN_CLUSTER;
+	m_NextFreeClusterHint = nextFreeClusterHint;
+
+	return false;
+}
+
+template <typename Traits>
+unsigned int FatFileManager<Traits>::calculateNumClusters() const
+{
+	// only the FAT entries that map to actual data clusters can be handed out
+	const unsigned int numRootDirSectors = ( (m_ActiveBootSector->getNumDirectoryEntriesInRoot() * FAT16_ENTRY_SIZE)
+							+ m_ActiveBootSector->getSectorSizeInBytes() - 1 ) / m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int numNonDataSectors = m_ActiveBootSector->getNumReservedSectors() + numRootDirSectors
+						+ ( m_ActiveBootSector->getNumFats() * m_ActiveBootSector->getNumSectorsPerFat() );
+	const unsigned int numDataSectors = ( m_ActiveBootSector->getNumSectorsOnDisk() > numNonDataSectors )
+						? m_ActiveBootSector->getNumSectorsOnDisk() - numNonDataSectors : 0;
+	const unsigned int numClustersInFat = ( m_ActiveBootSector->getNumSectorsPerFat() * m_ActiveBootSector->getSectorSizeInBytes() )
+						/ Traits::ENTRY_SIZE_IN_BYTES;
+
+	return std::min( (numDataSectors / m_ActiveBootSector->getNumSectorsPerCluster()) + 2, numClustersInFat );
+}
+
+template <typename Traits>
+unsigned int FatFileManager<Traits>::calculateNumReachableClusters() const
+{
+	const uint64_t clusterSizeInBytes = static_cast<uint64_t>( m_ActiveBootSector->getNumSectorsPerCluster() )
+						* m_ActiveBootSector->getSectorSizeInBytes();
+	const uint64_t numReachableClusters = ( (FAT_MEDIA_OFFSET_LIMIT - m_DataOffset) / clusterSizeInBytes ) + 2;
+
+	return static_cast<unsigned int>( numReachableClusters );
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::buildFreeClusterIndex()
+{
+	m_FreeClusterIndexIsBuilt = true;
+
+	// with an allocator the index is bounded to FAT_BITMAP_MAX_BITS clusters, which only FAT32 can go past. Clusters past the
+	// end of the index are still read from and counted, but are never handed out
+	m_FreeClusters.setNumBits( m_NumClusters );
+	m_PendingClustersToModify.setNumBits( m_NumClusters );
+
+	// the scan is exact, so it replaces a count taken from the FSInfo sector
+	m_NumFreeClustersIsKnown = true;
+	m_NumFreeClusters = 0;
+
+	// a paged FAT cache would load every sector one read at a time, so the FAT is scanned straight from the storage media in
+	// runs as big as the cache instead, except for sectors the cache already holds (which may be dirty)
+	const unsigned int sectorSize = m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int numClustersPerSector = sectorSize / Traits::ENTRY_SIZE_IN_BYTES;
+	const unsigned int numIndexedClusters = m_FreeClusters.getNumBits();
+	const unsigned int numSectorsToScan = ( m_NumClusters + numClustersPerSector - 1 ) / numClustersPerSector;
+	const unsigned int numSectorsPerRun = ( m_FatCache.isPaged() ) ? m_FatCache.getNumPages() : numSectorsToScan;
+
+	for ( unsigned int runStartSector = 0; runStartSector < numSectorsToScan; runStartSector += numSectorsPerRun )
+	{
+		const unsigned int numSectorsInRun = std::min( numSectorsPerRun, numSectorsToScan - runStartSector );
+		SharedData<uint8_t> runData = SharedData<uint8_t>::MakeSharedDataNull();
+		if ( m_FatCache.isPaged() )
+		{
+			runData = m_MediaIo.read( FatIoType::FAT_READ, numSectorsInRun * sectorSize, m_FatOffset + (runStartSector * sectorSize) );
+		}
+
+		for ( unsigned int sector = runStartSector; sector < runStartSector + numSectorsInRun; sector++ )
+		{
+			const uint8_t* sectorPtr = m_FatCache.findSector( sector );
+			if ( ! sectorPtr )
+			{
+				sectorPtr = ( m_FatCache.isPaged() ) ? &runData[(sector - runStartSector) * sectorSize] : m_FatCache.getSector( sector );
+			}
+
+			// the entries are compared against free a word of clusters at a time, and the bits go straight into the index
+			const unsigned int sectorFirstClusterNum = sector * numClustersPerSector;
+			const unsigned int numClustersInSector = std::min( numClustersPerSector, m_NumClusters - sectorFirstClusterNum );
+			for ( unsigned int chunkStart = 0; chunkStart < numClustersInSector; chunkStart += FAT_FREE_SCAN_CHUNK_SIZE )
+			{
+				const unsigned int firstClusterNum = sectorFirstClusterNum + chunkStart;
+				const unsigned int numClustersInChunk = std::min( FAT_FREE_SCAN_CHUNK_SIZE, numClustersInSector - chunkStart );
+
+				uint32_t freeMask[FAT_FREE_SCAN_CHUNK_SIZE / FAT_BITMAP_BITS_PER_WORD];
+				unsigned int numFreeClustersInChunk = Traits::scanForFreeClusters( &sectorPtr[chunkStart * Traits::ENTRY_SIZE_IN_BYTES],
+													numClustersInChunk, freeMask );
+
+				// the first two entries are reserved, whatever they hold
+				if ( firstClusterNum == 0 )
+				{
+					numFreeClustersInChunk -= __builtin_popcount( freeMask[0] & 0x3 );
+					freeMask[0] &= ~0x3u;
+				}
+
+				if ( firstClusterNum < numIndexedClusters ) m_FreeClusters.setBits( firstClusterNum, freeMask, numClustersInChunk );
+				m_NumFreeClusters += numFreeClustersInChunk;
+			}
+		}
+	}
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::buildFreeClusterIndexIfDeferred()
+{
+	if ( ! m_FreeClusterIndexIsBuilt )
+	{
+		this->buildFreeClusterIndex();
+	}
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::updateFreeClusterIndex (uint32_t cluster, uint32_t oldClusterVal, uint32_t newClusterVal)
+{
+	if ( cluster < 2 || cluster >= m_NumClusters ) return;
+
+	// the count is kept up to date whether it came from a scan of the FAT or from the FSInfo sector
+	if ( m_NumFreeClustersIsKnown && oldClusterVal == Traits::FREE_CLUSTER && newClusterVal != Traits::FREE_CLUSTER )
+	{
+		m_NumFreeClusters--;
+	}
+	else if ( m_NumFreeClustersIsKnown && oldClusterVal != Traits::FREE_CLUSTER && newClusterVal == Traits::FREE_CLUSTER )
+	{
+		m_NumFreeClusters++;
+	}
+
+	// a deferred index is built from the FAT itself, so it will pick this change up then
+	if ( ! m_FreeClusterIndexIsBuilt || cluster >= m_FreeClusters.getNumBits() ) return;
+
+	if ( newClusterVal == Traits::FREE_CLUSTER )
+	{
+		m_FreeClusters.setBit( cluster );
+	}
+	else
+	{
+		m_FreeClusters.clearBit( cluster );
+	}
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::loadFsInfo (unsigned int partitionOffset)
+{
+	// a sector number of 0 or 0xFFFF means the file system doesn't have one
+	const uint16_t fsInfoSectorNum = m_ActiveBootSector->getFSInfoSectorNum();
+	if ( fsInfoSectorNum == 0 || fsInfoSectorNum == 0xFFFF ) return;
+
+	m_FsInfoOffset = ( partitionOffset + fsInfoSectorNum ) * m_ActiveBootSector->getSectorSizeInBytes();
+	SharedData<uint8_t> fsInfoData = m_MediaIo.read( FatIoType::FAT_READ, FS_INFO_SIZE_IN_BYTES, m_FsInfoOffset );
+
+	const Fat32FsInfo fsInfo( fsInfoData.getPtr() );
+	if ( ! fsInfo.signaturesAreValid() ) return;
+
+	if ( m_Allocator )
+	{
+		m_FsInfo = m_Allocator->allocate<Fat32FsInfo>( fsInfo );
+	}
+	else
+	{
+		m_FsInfo = new Fat32FsInfo( fsInfo );
+	}
+
+	// the count covers the whole volume, so it can't be used when only part of the volume can be reached
+	const uint32_t numFreeClusters = m_FsInfo->getNumFreeClusters();
+	if ( numFreeClusters != FS_INFO_UNKNOWN && ! m_ClustersAreUnreachable && m_NumClusters > 2 && numFreeClusters <= m_NumClusters - 2 )
+	{
+		m_NumFreeClusters = numFreeClusters;
+		m_NumFreeClustersIsKnown = true;
+	}
+
+	const uint32_t nextFreeCluster = m_FsInfo->getNextFreeCluster();
+	if ( nextFreeCluster >= 2 && nextFreeCluster < m_NumClusters )
+	{
+		m_NextFreeClusterHint = nextFreeCluster;
+	}
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::writeFsInfoIfChanged()
+{
+	if ( ! m_FsInfo ) return;
+
+	// a count of only the clusters that can be reached would be wrong for the whole volume
+	const uint32_t numFreeClusters = ( m_NumFreeClustersIsKnown && ! m_ClustersAreUnreachable ) ? m_NumFreeClusters : FS_INFO_UNKNOWN;
+	if ( numFreeClusters == m_FsInfo->getNumFreeClusters() && m_NextFreeClusterHint == m_FsInfo->getNextFreeCluster() ) return;
+
+	m_FsInfo->setNumFreeClusters( numFreeClusters );
+	m_FsInfo->setNextFreeCluster( m_NextFreeClusterHint );
+
+	SharedData<uint8_t> fsInfoData = SharedData<uint8_t>::MakeSharedData( FS_INFO_SIZE_IN_BYTES );
+	memcpy( fsInfoData.getPtr(), m_FsInfo->getUnderlyingData(), FS_INFO_SIZE_IN_BYTES );
+	m_MediaIo.write( FatIoType::FAT_WRITE, fsInfoData, m_FsInfoOffset );
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::isReadableFile (const Fat16Entry& entry)
+{
+	return ( ! entry.isRootDirectory()
+			&& ! entry.isSubdirectory()
+			&& ! entry.isUnusedEntry()
+			&& ! entry.isDeletedEntry()
+			&& ! entry.isHiddenEntry()
+			&& ! entry.isSystemFile()
+			&& ! entry.isDiskVolumeLabel() );
+}
+
+template <typename Traits>
+unsigned int FatFileManager<Traits>::getClusterOffset (uint32_t cluster) const
+{
+	return m_DataOffset + ( (cluster - 2) * m_ActiveBootSector->getNumSectorsPerCluster() * m_ActiveBootSector->getSectorSizeInBytes() );
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::loadCurrentDirectory (uint32_t dirCluster)
+{
+	this->freeDirectoryEntriesInVecAndClear( m_CurrentDirectoryEntries );
+
+	m_CurrentDirOffset = ( dirCluster == 0 ) ? m_RootDirectoryOffset : this->getClusterOffset( dirCluster );
+	m_CurrentDirectoryIsLoaded = true;
+	m_CurrentDirectoryData = this->readDirectory( dirCluster, m_CurrentDirectoryClusters );
+	m_CurrentDirectoryDataIsShared = false;
+	m_NumCurrentDirectoryEntries = m_CurrentDirectoryData.getSizeInBytes() / FAT16_ENTRY_SIZE;
+
+	m_CurrentDirectoryIndex.build( m_CurrentDirectoryData.getPtr(), m_NumCurrentDirectoryEntries );
+}
+
+template <typename Traits>
+SharedData<uint8_t> FatFileManager<Traits>::readDirectory (uint32_t dirCluster, std::vector<uint32_t>& clusters)
+{
+	clusters.clear();
+
+	if ( dirCluster == 0 && Traits::HAS_FIXED_ROOT_DIRECTORY )
+	{
+		return m_MediaIo.read( FatIoType::DIRECTORY_READ, m_ActiveBootSector->getNumDirectoryEntriesInRoot() * FAT16_ENTRY_SIZE,
+					m_RootDirectoryOffset );
+	}
+	else if ( dirCluster == 0 )
+	{
+		dirCluster = m_RootDirectoryCluster;
+	}
+
+	// walk the chain in the cached FAT first, so the size of the whole directory is known before reading any of it
+	const unsigned int clusterSizeInBytes = m_ActiveBootSector->getNumSectorsPerCluster() * m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int maxNumClusters = ( FAT_MAX_DIRECTORY_ENTRIES * FAT16_ENTRY_SIZE ) / clusterSizeInBytes;
+	uint32_t cluster = dirCluster;
+	while ( ! this->clusterIsEndOfChain(cluster) && cluster < m_NumClusters && clusters.size() < maxNumClusters )
+	{
+		clusters.push_back( cluster );
+		cluster = this->lockAndGetNextClusterInChain( cluster );
+	}
+
+	if ( clusters.empty() ) return SharedData<uint8_t>::MakeSharedDataNull();
+
+	// each run of adjacent clusters is read with a single read, and a directory that is one run is used as read
+	SharedData<uint8_t> dirData = SharedData<uint8_t>::MakeSharedDataNull();
+	unsigned int runStart = 0;
+	while ( runStart < clusters.size() )
+	{
+		unsigned int runEnd = runStart + 1;
+		while ( runEnd < clusters.size() && clusters[runEnd] == clusters[runEnd - 1] + 1 )
+		{
+			runEnd++;
+		}
+
+		SharedData<uint8_t> runData = m_MediaIo.read( FatIoType::DIRECTORY_READ, (runEnd - runStart) * clusterSizeInBytes,
+								this->getClusterOffset(clusters[runStart]) );
+		if ( runStart == 0 && runEnd == clusters.size() ) return runData;
+
+		if ( runStart == 0 )
+		{
+			dirData = SharedData<uint8_t>::MakeSharedData( clusters.size() * clusterSizeInBytes );
+		}
+		memcpy( dirData.getPtr() + (runStart * clusterSizeInBytes), runData.getPtr(), runData.getSizeInBytes() );
+
+		runStart = runEnd;
+	}
+
+	return dirData;
+}
+
+template <typename Traits>
+unsigned int FatFileManager<Traits>::getDirectoryEntryOffset (const std::vector<uint32_t>& clusters, unsigned int entryNum) const
+{
+	if ( clusters.empty() ) return m_RootDirectoryOffset + ( entryNum * FAT16_ENTRY_SIZE );
+
+	const unsigned int clusterSizeInBytes = m_ActiveBootSector->getNumSectorsPerCluster() * m_ActiveBootSector->getSectorSizeInBytes();
+	const unsigned int numEntriesPerCluster = clusterSizeInBytes / FAT16_ENTRY_SIZE;
+
+	return this->getClusterOffset( clusters[entryNum / numEntriesPerCluster] ) + ( (entryNum % numEntriesPerCluster) * FAT16_ENTRY_SIZE );
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::growDirectory (std::vector<uint32_t>& clusters)
+{
+	const unsigned int clusterSizeInBytes = m_ActiveBootSector->getNumSectorsPerCluster() * m_ActiveBootSector->getSectorSizeInBytes();
+	if ( (clusters.size() + 1) * clusterSizeInBytes > FAT_MAX_DIRECTORY_ENTRIES * FAT16_ENTRY_SIZE ) return false;
+
+	uint32_t newCluster = Traits::FREE_CLUSTER;
+	{
+		FatLockGuard fatGuard( m_FatLock );
+
+		newCluster = this->findFreeCluster( m_NextFreeClusterHint );
+		if ( newCluster == Traits::FREE_CLUSTER ) return false;
+
+		// the FAT change goes out with the rest of the entry's FAT changes, after the cleared cluster is written below
+		this->setClusterValue( newCluster, Traits::END_OF_CHAIN_CLUSTER );
+		this->setClusterValue( clusters.back(), newCluster );
+		m_NextFreeClusterHint = newCluster + 1;
+	}
+
+	// a cleared cluster reads as the end of the directory after whatever is written to its first entry
+	SharedData<uint8_t> clearedCluster = SharedData<uint8_t>::MakeSharedData( clusterSizeInBytes );
+	memset( clearedCluster.getPtr(), 0, clusterSizeInBytes );
+	m_MediaIo.write( FatIoType::DIRECTORY_WRITE, clearedCluster, this->getClusterOffset(newCluster) );
+
+	clusters.push_back( newCluster );
+
+	return true;
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::loadCurrentDirectoryIfDeferred()
+{
+	// with a lazy mount, the current directory is the root directory until something is loaded
+	if ( ! m_CurrentDirectoryIsLoaded )
+	{
+		this->loadCurrentDirectory( 0 );
+	}
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::setCurrentDirectoryEntry (unsigned int entryNum, const Fat16Entry& entry)
+{
+	// directory views handed out still point at the old data, so the change goes into a copy they don't see. Views taken
+	// after this see the copy, and the copy is only copied again if one is
+	if ( m_CurrentDirectoryDataIsShared )
+	{
+		SharedData<uint8_t> directoryData = SharedData<uint8_t>::MakeSharedData( m_CurrentDirectoryData.getSizeInBytes() );
+		memcpy( directoryData.getPtr(), m_CurrentDirectoryData.getPtr(), m_CurrentDirectoryData.getSizeInBytes() );
+
+		m_CurrentDirectoryData = directoryData;
+		m_CurrentDirectoryDataIsShared = false;
+	}
+
+	memcpy( &m_CurrentDirectoryData[entryNum * FAT16_ENTRY_SIZE], entry.getUnderlyingData(), FAT16_ENTRY_SIZE );
+
+	// keep the entry objects in step, if they have been created
+	if ( m_CurrentDirectoryEntries.size() == m_NumCurrentDirectoryEntries )
+	{
+		*m_CurrentDirectoryEntries.at( entryNum ) = entry;
+	}
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::writeDirectoryEntriesToVec (std::vector<Fat16Entry*>& vec, const uint8_t* directoryData, unsigned int numDirectoryEntries)
+{
+	// fill directory entries vector
+	if ( m_Allocator )
+	{
+		for ( unsigned int entry = 0; entry < numDirectoryEntries; entry++ )
+		{
+			vec.push_back( m_Allocator->allocate<Fat16Entry>(&directoryData[entry * FAT16_ENTRY_SIZE]) );
+		}
+	}
+	else
+	{
+		for ( unsigned int entry = 0; entry < numDirectoryEntries; entry++ )
+		{
+			vec.push_back( new Fat16Entry(&directoryData[entry * FAT16_ENTRY_SIZE]) );
+		}
+	}
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::freeDirectoryEntriesInVecAndClear (std::vector<Fat16Entry*>& vec)
+{
+	// free directory entries and clear
+	if ( m_Allocator )
+	{
+		for ( Fat16Entry* entryPtr : vec )
+		{
+			m_Allocator->free<Fat16Entry>( entryPtr );
+		}
+	}
+	else
+	{
+		for ( Fat16Entry* entryPtr : vec )
+		{
+			delete entryPtr;
+		}
+	}
+
+	vec.clear();
+}
+
+template <typename Traits>
+void FatFileManager<Traits>::writeEntryToStorageMedia (const Fat16Entry& entry, unsigned int entryOffset)
+{
+	SharedData<uint8_t> entryData = SharedData<uint8_t>::MakeSharedData( FAT16_ENTRY_SIZE );
+	const uint8_t* underlyingData = entry.getUnderlyingData();
+	for ( unsigned int byte = 0; byte < FAT16_ENTRY_SIZE; byte++ )
+	{
+		entryData[byte] = underlyingData[byte];
+	}
+
+	m_MediaIo.write( FatIoType::DIRECTORY_WRITE, entryData, entryOffset );
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::findEntryInDirectory (uint32_t dirCluster, const char* filenameRaw, const char* extensionRaw, uint8_t* entryData)
+{
+	const unsigned int clusterSizeInBytes = m_ActiveBootSector->getNumSectorsPerCluster() * m_ActiveBootSector->getSectorSizeInBytes();
+
+	// a fixed root directory is one region, other directories are read a cluster at a time along their cluster chain
+	const bool isFixedRootDirectory = ( dirCluster == 0 && Traits::HAS_FIXED_ROOT_DIRECTORY );
+	uint32_t cluster = ( dirCluster == 0 ) ? m_RootDirectoryCluster : dirCluster;
+	unsigned int numClustersRead = 0;
+	while ( numClustersRead < m_NumClusters )
+	{
+		SharedData<uint8_t> dirData = ( isFixedRootDirectory )
+			? m_MediaIo.read( FatIoType::DIRECTORY_READ, m_ActiveBootSector->getNumDirectoryEntriesInRoot() * FAT16_ENTRY_SIZE,
+						m_RootDirectoryOffset )
+			: m_MediaIo.read( FatIoType::DIRECTORY_READ, clusterSizeInBytes, this->getClusterOffset(cluster) );
+		const uint8_t* dirDataPtr = dirData.getPtr();
+		const unsigned int numEntries = dirData.getSizeInBytes() / FAT16_ENTRY_SIZE;
+
+		for ( unsigned int entryNum = 0; entryNum < numEntries; entryNum++ )
+		{
+			const uint8_t* entryPtr = &dirDataPtr[entryNum * FAT16_ENTRY_SIZE];
+
+			// an unused entry marks the end of the directory
+			if ( entryPtr[FAT16_FILENAME_OFFSET] == 0x00 ) return false;
+
+			if ( memcmp(&entryPtr[FAT16_FILENAME_OFFSET], filenameRaw, FAT16_FILENAME_SIZE) == 0
+					&& memcmp(&entryPtr[FAT16_EXTENSION_OFFSET], extensionRaw, FAT16_EXTENSION_SIZE) == 0 )
+			{
+				memcpy( entryData, entryPtr, FAT16_ENTRY_SIZE );
+
+				return true;
+			}
+		}
+
+		if ( isFixedRootDirectory ) return false;
+
+		cluster = this->lockAndGetNextClusterInChain( cluster );
+		if ( this->clusterIsEndOfChain(cluster) || cluster >= m_NumClusters ) return false;
+
+		numClustersRead++;
+	}
+
+	return false;
+}
+
+template <typename Traits>
+uint32_t FatFileManager<Traits>::getDirectoryCluster (unsigned int directoryOffset) const
+{
+	// the root directory is always 0, even when it is a cluster chain
+	if ( directoryOffset == m_RootDirectoryOffset ) return 0;
+
+	const unsigned int clusterSizeInBytes = m_ActiveBootSector->getNumSectorsPerCluster() * m_ActiveBootSector->getSectorSizeInBytes();
+
+	return ( (directoryOffset - m_DataOffset) / clusterSizeInBytes ) + 2;
+}
+
+template <typename Traits>
+bool FatFileManager<Traits>::makeRawName (const std::string& filename, const std::string& extension, char* filenameRaw, char* extensionRaw)
+{
+	if ( filename.empty() || filename.size() > FAT16_FILENAME_SIZE || extension.size() > FAT16_EXTENSION_SIZE ) return false;
+
+	// directory entries store names padded with spaces
+	memset( filenameRaw, ' ', FAT16_FILENAME_SIZE );
+	memset( extensionRaw, ' ', FAT16_EXTENSION_SIZE );
+	memcpy( filenameRaw, filename.c_str(), filename.size() );
+	memcpy( extensionRaw, extension.c_str(), extension.size() );
+
+	return true;
+}
+
+template class FatFileManager<Fat16Traits>;
+template class FatFileManager<Fat32Traits>;
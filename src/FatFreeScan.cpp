@@ -0,0 +1,386 @@
+#include "FatFreeScan.hpp"
+
+#include <string.h>
+
+// every kernel but the scalar one reads the entries straight into wider registers, so they're only built for little endian
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define FAT_FREE_SCAN_HAS_SWAR
+#if defined(__SSE2__)
+#define FAT_FREE_SCAN_HAS_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define FAT_FREE_SCAN_HAS_AVX2
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define FAT_FREE_SCAN_HAS_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+#define FAT_FREE_SCAN_ENTRIES_PER_WORD 	32
+
+// the vector kernels do whole words of entries, and leave whatever is left over to these
+static unsigned int scanFat16Tail (const uint8_t* entries, unsigned int firstEntry, unsigned int numEntries, uint32_t* freeMask)
+{
+	unsigned int numFree = 0;
+	for ( unsigned int entry = firstEntry; entry < numEntries; entry++ )
+	{
+		if ( entry % FAT_FREE_SCAN_ENTRIES_PER_WORD == 0 ) freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] = 0;
+
+		const uint8_t* entryPtr = &entries[entry * 2];
+		if ( (entryPtr[0] | (entryPtr[1] << 8)) == 0x0000 )
+		{
+			freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] |= ( 1u << (entry % FAT_FREE_SCAN_ENTRIES_PER_WORD) );
+			numFree++;
+		}
+	}
+
+	return numFree;
+}
+
+// only the low 28 bits of a FAT32 entry are the cluster value
+static unsigned int scanFat32Tail (const uint8_t* entries, unsigned int firstEntry, unsigned int numEntries, uint32_t* freeMask)
+{
+	unsigned int numFree = 0;
+	for ( unsigned int entry = firstEntry; entry < numEntries; entry++ )
+	{
+		if ( entry % FAT_FREE_SCAN_ENTRIES_PER_WORD == 0 ) freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] = 0;
+
+		const uint8_t* entryPtr = &entries[entry * 4];
+		if ( (entryPtr[0] | (entryPtr[1] << 8) | (entryPtr[2] << 16) | ((entryPtr[3] & 0x0F) << 24)) == 0x00000000 )
+		{
+			freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] |= ( 1u << (entry % FAT_FREE_SCAN_ENTRIES_PER_WORD) );
+			numFree++;
+		}
+	}
+
+	return numFree;
+}
+
+#ifdef FAT_FREE_SCAN_HAS_SWAR
+static unsigned int scanFat16Swar (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	unsigned int numFree = 0;
+	unsigned int entry = 0;
+	for ( ; entry + FAT_FREE_SCAN_ENTRIES_PER_WORD <= numEntries; entry += FAT_FREE_SCAN_ENTRIES_PER_WORD )
+	{
+		uint32_t mask = 0;
+		for ( unsigned int group = 0; group < 8; group++ )
+		{
+			uint64_t entryGroup;
+			memcpy( &entryGroup, &entries[(entry + (group * 4)) * 2], sizeof(entryGroup) );
+
+			// the top bit of each 16 bit lane ends up set if the lane is nonzero, without carrying into the next lane
+			const uint64_t nonzeroLanes = ( ((entryGroup & 0x7FFF7FFF7FFF7FFFULL) + 0x7FFF7FFF7FFF7FFFULL) | entryGroup )
+							& 0x8000800080008000ULL;
+			const uint64_t freeLanes = ( nonzeroLanes ^ 0x8000800080008000ULL ) >> 15;
+
+			// the multiply gathers the lane bits (at bits 0, 16, 32 and 48) into bits 45 to 48 without any carries
+			mask |= static_cast<uint32_t>( ((freeLanes * 0x0000200040008001ULL) >> 45) & 0xF ) << ( group * 4 );
+		}
+
+		freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] = mask;
+		numFree += __builtin_popcount( mask );
+	}
+
+	return numFree + scanFat16Tail( entries, entry, numEntries, freeMask );
+}
+
+static unsigned int scanFat32Swar (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	unsigned int numFree = 0;
+	unsigned int entry = 0;
+	for ( ; entry + FAT_FREE_SCAN_ENTRIES_PER_WORD <= numEntries; entry += FAT_FREE_SCAN_ENTRIES_PER_WORD )
+	{
+		uint32_t mask = 0;
+		for ( unsigned int group = 0; group < 16; group++ )
+		{
+			uint64_t entryGroup;
+			memcpy( &entryGroup, &entries[(entry + (group * 2)) * 4], sizeof(entryGroup) );
+
+			// each masked lane is at most 28 bits, so adding 0x7FFFFFFF sets its top bit exactly when it's nonzero
+			const uint64_t nonzeroLanes = ( (entryGroup & 0x0FFFFFFF0FFFFFFFULL) + 0x7FFFFFFF7FFFFFFFULL ) & 0x8000000080000000ULL;
+			const uint64_t freeLanes = nonzeroLanes ^ 0x8000000080000000ULL;
+
+			mask |= static_cast<uint32_t>( ((freeLanes >> 31) & 0x1) | ((freeLanes >> 62) & 0x2) ) << ( group * 2 );
+		}
+
+		freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] = mask;
+		numFree += __builtin_popcount( mask );
+	}
+
+	return numFree + scanFat32Tail( entries, entry, numEntries, freeMask );
+}
+#endif
+
+#ifdef FAT_FREE_SCAN_HAS_SSE2
+static unsigned int scanFat16Sse2 (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	unsigned int numFree = 0;
+	unsigned int entry = 0;
+	for ( ; entry + FAT_FREE_SCAN_ENTRIES_PER_WORD <= numEntries; entry += FAT_FREE_SCAN_ENTRIES_PER_WORD )
+	{
+		const __m128i* entryGroups = reinterpret_cast<const __m128i*>( &entries[entry * 2] );
+		const __m128i free0 = _mm_cmpeq_epi16( _mm_loadu_si128(&entryGroups[0]), zero );
+		const __m128i free1 = _mm_cmpeq_epi16( _mm_loadu_si128(&entryGroups[1]), zero );
+		const __m128i free2 = _mm_cmpeq_epi16( _mm_loadu_si128(&entryGroups[2]), zero );
+		const __m128i free3 = _mm_cmpeq_epi16( _mm_loadu_si128(&entryGroups[3]), zero );
+
+		// narrowing to bytes keeps the entries in order, so the byte mask is the entry mask
+		const uint32_t mask = static_cast<uint32_t>( _mm_movemask_epi8(_mm_packs_epi16(free0, free1)) )
+					| ( static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(free2, free3))) << 16 );
+
+		freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] = mask;
+		numFree += __builtin_popcount( mask );
+	}
+
+	return numFree + scanFat16Tail( entries, entry, numEntries, freeMask );
+}
+
+static unsigned int scanFat32Sse2 (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i valueMask = _mm_set1_epi32( 0x0FFFFFFF );
+
+	unsigned int numFree = 0;
+	unsigned int entry = 0;
+	for ( ; entry + FAT_FREE_SCAN_ENTRIES_PER_WORD <= numEntries; entry += FAT_FREE_SCAN_ENTRIES_PER_WORD )
+	{
+		const __m128i* entryGroups = reinterpret_cast<const __m128i*>( &entries[entry * 4] );
+		uint32_t mask = 0;
+		for ( unsigned int group = 0; group < 8; group++ )
+		{
+			const __m128i values = _mm_and_si128( _mm_loadu_si128(&entryGroups[group]), valueMask );
+			const __m128i isFree = _mm_cmpeq_epi32( values, zero );
+			mask |= static_cast<uint32_t>( _mm_movemask_ps(_mm_castsi128_ps(isFree)) ) << ( group * 4 );
+		}
+
+		freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] = mask;
+		numFree += __builtin_popcount( mask );
+	}
+
+	return numFree + scanFat32Tail( entries, entry, numEntries, freeMask );
+}
+#endif
+
+#ifdef FAT_FREE_SCAN_HAS_AVX2
+__attribute__((target("avx2")))
+static unsigned int scanFat16Avx2 (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	const __m256i zero = _mm256_setzero_si256();
+
+	unsigned int numFree = 0;
+	unsigned int entry = 0;
+	for ( ; entry + FAT_FREE_SCAN_ENTRIES_PER_WORD <= numEntries; entry += FAT_FREE_SCAN_ENTRIES_PER_WORD )
+	{
+		const __m256i* entryGroups = reinterpret_cast<const __m256i*>( &entries[entry * 2] );
+		const __m256i free0 = _mm256_cmpeq_epi16( _mm256_loadu_si256(&entryGroups[0]), zero );
+		const __m256i free1 = _mm256_cmpeq_epi16( _mm256_loadu_si256(&entryGroups[1]), zero );
+
+		// narrowing works within each 128 bit half, so the middle two 64 bit quarters have to be swapped back into order
+		const __m256i isFree = _mm256_permute4x64_epi64( _mm256_packs_epi16(free0, free1), 0xD8 );
+		const uint32_t mask = static_cast<uint32_t>( _mm256_movemask_epi8(isFree) );
+
+		freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] = mask;
+		numFree += __builtin_popcount( mask );
+	}
+
+	return numFree + scanFat16Tail( entries, entry, numEntries, freeMask );
+}
+
+__attribute__((target("avx2")))
+static unsigned int scanFat32Avx2 (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i valueMask = _mm256_set1_epi32( 0x0FFFFFFF );
+
+	unsigned int numFree = 0;
+	unsigned int entry = 0;
+	for ( ; entry + FAT_FREE_SCAN_ENTRIES_PER_WORD <= numEntries; entry += FAT_FREE_SCAN_ENTRIES_PER_WORD )
+	{
+		const __m256i* entryGroups = reinterpret_cast<const __m256i*>( &entries[entry * 4] );
+		uint32_t mask = 0;
+		for ( unsigned int group = 0; group < 4; group++ )
+		{
+			const __m256i values = _mm256_and_si256( _mm256_loadu_si256(&entryGroups[group]), valueMask );
+			const __m256i isFree = _mm256_cmpeq_epi32( values, zero );
+			mask |= static_cast<uint32_t>( _mm256_movemask_ps(_mm256_castsi256_ps(isFree)) ) << ( group * 8 );
+		}
+
+		freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] = mask;
+		numFree += __builtin_popcount( mask );
+	}
+
+	return numFree + scanFat32Tail( entries, entry, numEntries, freeMask );
+}
+#endif
+
+#ifdef FAT_FREE_SCAN_HAS_NEON
+static unsigned int scanFat16Neon (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	static const uint8_t laneBits[8] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+	const uint8x8_t laneBitsVec = vld1_u8( laneBits );
+	const uint16x8_t zero = vdupq_n_u16( 0 );
+
+	unsigned int numFree = 0;
+	unsigned int entry = 0;
+	for ( ; entry + FAT_FREE_SCAN_ENTRIES_PER_WORD <= numEntries; entry += FAT_FREE_SCAN_ENTRIES_PER_WORD )
+	{
+		uint32_t mask = 0;
+		for ( unsigned int group = 0; group < 4; group++ )
+		{
+			const uint16x8_t values = vreinterpretq_u16_u8( vld1q_u8(&entries[(entry + (group * 8)) * 2]) );
+			const uint8x8_t isFree = vmovn_u16( vceqq_u16(values, zero) );
+			mask |= static_cast<uint32_t>( vaddv_u8(vand_u8(isFree, laneBitsVec)) ) << ( group * 8 );
+		}
+
+		freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] = mask;
+		numFree += __builtin_popcount( mask );
+	}
+
+	return numFree + scanFat16Tail( entries, entry, numEntries, freeMask );
+}
+
+static unsigned int scanFat32Neon (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	static const uint16_t laneBits[4] = { 0x1, 0x2, 0x4, 0x8 };
+	const uint16x4_t laneBitsVec = vld1_u16( laneBits );
+	const uint32x4_t zero = vdupq_n_u32( 0 );
+	const uint32x4_t valueMask = vdupq_n_u32( 0x0FFFFFFF );
+
+	unsigned int numFree = 0;
+	unsigned int entry = 0;
+	for ( ; entry + FAT_FREE_SCAN_ENTRIES_PER_WORD <= numEntries; entry += FAT_FREE_SCAN_ENTRIES_PER_WORD )
+	{
+		uint32_t mask = 0;
+		for ( unsigned int group = 0; group < 8; group++ )
+		{
+			const uint32x4_t values = vandq_u32( vreinterpretq_u32_u8(vld1q_u8(&entries[(entry + (group * 4)) * 4])), valueMask );
+			const uint16x4_t isFree = vmovn_u32( vceqq_u32(values, zero) );
+			mask |= static_cast<uint32_t>( vaddv_u16(vand_u16(isFree, laneBitsVec)) ) << ( group * 4 );
+		}
+
+		freeMask[entry / FAT_FREE_SCAN_ENTRIES_PER_WORD] = mask;
+		numFree += __builtin_popcount( mask );
+	}
+
+	return numFree + scanFat32Tail( entries, entry, numEntries, freeMask );
+}
+#endif
+
+unsigned int FatFreeScan::scanFat16 (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	switch ( FatFreeScan::getActiveKernel() )
+	{
+#ifdef FAT_FREE_SCAN_HAS_SWAR
+		case FatFreeScanKernel::SWAR:
+			return scanFat16Swar( entries, numEntries, freeMask );
+#endif
+#ifdef FAT_FREE_SCAN_HAS_SSE2
+		case FatFreeScanKernel::SSE2:
+			return scanFat16Sse2( entries, numEntries, freeMask );
+#endif
+#ifdef FAT_FREE_SCAN_HAS_AVX2
+		case FatFreeScanKernel::AVX2:
+			return scanFat16Avx2( entries, numEntries, freeMask );
+#endif
+#ifdef FAT_FREE_SCAN_HAS_NEON
+		case FatFreeScanKernel::NEON:
+			return scanFat16Neon( entries, numEntries, freeMask );
+#endif
+		default:
+			return FatFreeScan::scanFat16Scalar( entries, numEntries, freeMask );
+	}
+}
+
+unsigned int FatFreeScan::scanFat32 (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	switch ( FatFreeScan::getActiveKernel() )
+	{
+#ifdef FAT_FREE_SCAN_HAS_SWAR
+		case FatFreeScanKernel::SWAR:
+			return scanFat32Swar( entries, numEntries, freeMask );
+#endif
+#ifdef FAT_FREE_SCAN_HAS_SSE2
+		case FatFreeScanKernel::SSE2:
+			return scanFat32Sse2( entries, numEntries, freeMask );
+#endif
+#ifdef FAT_FREE_SCAN_HAS_AVX2
+		case FatFreeScanKernel::AVX2:
+			return scanFat32Avx2( entries, numEntries, freeMask );
+#endif
+#ifdef FAT_FREE_SCAN_HAS_NEON
+		case FatFreeScanKernel::NEON:
+			return scanFat32Neon( entries, numEntries, freeMask );
+#endif
+		default:
+			return FatFreeScan::scanFat32Scalar( entries, numEntries, freeMask );
+	}
+}
+
+unsigned int FatFreeScan::scanFat16Scalar (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	return scanFat16Tail( entries, 0, numEntries, freeMask );
+}
+
+unsigned int FatFreeScan::scanFat32Scalar (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask)
+{
+	return scanFat32Tail( entries, 0, numEntries, freeMask );
+}
+
+FatFreeScanKernel FatFreeScan::getKernel()
+{
+	return FatFreeScan::getActiveKernel();
+}
+
+bool FatFreeScan::setKernel (const FatFreeScanKernel& kernel)
+{
+	if ( ! FatFreeScan::kernelIsSupported(kernel) ) return false;
+
+	FatFreeScan::getActiveKernel() = kernel;
+
+	return true;
+}
+
+bool FatFreeScan::kernelIsSupported (const FatFreeScanKernel& kernel)
+{
+	switch ( kernel )
+	{
+		case FatFreeScanKernel::SCALAR:
+			return true;
+#ifdef FAT_FREE_SCAN_HAS_SWAR
+		case FatFreeScanKernel::SWAR:
+			return true;
+#endif
+#ifdef FAT_FREE_SCAN_HAS_SSE2
+		case FatFreeScanKernel::SSE2:
+			return true;
+#endif
+#ifdef FAT_FREE_SCAN_HAS_AVX2
+		case FatFreeScanKernel::AVX2:
+			return __builtin_cpu_supports( "avx2" );
+#endif
+#ifdef FAT_FREE_SCAN_HAS_NEON
+		case FatFreeScanKernel::NEON:
+			return true;
+#endif
+		default:
+			return false;
+	}
+}
+
+FatFreeScanKernel& FatFreeScan::getActiveKernel()
+{
+	// picked once, on first use, from the fastest kernel down
+	static FatFreeScanKernel activeKernel = ( FatFreeScan::kernelIsSupported(FatFreeScanKernel::AVX2) ) ? FatFreeScanKernel::AVX2
+						: ( FatFreeScan::kernelIsSupported(FatFreeScanKernel::SSE2) ) ? FatFreeScanKernel::SSE2
+						: ( FatFreeScan::kernelIsSupported(FatFreeScanKernel::NEON) ) ? FatFreeScanKernel::NEON
+						: ( FatFreeScan::kernelIsSupported(FatFreeScanKernel::SWAR) ) ? FatFreeScanKernel::SWAR
+						: FatFreeScanKernel::SCALAR;
+
+	return activeKernel;
+}
@@ -0,0 +1,175 @@
+#include "FatMediaIo.hpp"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char* const ioTypeNames[FAT_IO_NUM_TYPES] = { "fat_read", "fat_write", "directory_read", "directory_write", "data_read",
+								"data_write" };
+
+// returns false once the buffer is full, in which case numChars is left at the end of the (terminated) buffer
+static bool appendToBuffer (char* buffer, unsigned int bufferSizeInBytes, unsigned int& numChars, const char* format, ...)
+{
+	va_list args;
+	va_start( args, format );
+	const int written = vsnprintf( &buffer[numChars], bufferSizeInBytes - numChars, format, args );
+	va_end( args );
+
+	if ( written < 0 ) return false;
+
+	numChars += written;
+	if ( numChars >= bufferSizeInBytes )
+	{
+		numChars = bufferSizeInBytes - 1;
+
+		return false;
+	}
+
+	return true;
+}
+
+FatMediaIo::FatMediaIo (IStorageMedia& storageMedia) :
+	m_StorageMedia( storageMedia ),
+	m_AsyncStorageMedia( nullptr ),
+	m_Instrumentation( nullptr ),
+	m_Stats(),
+	m_StatsLock( nullptr )
+{
+	this->resetStats();
+}
+
+SharedData<uint8_t> FatMediaIo::read (const FatIoType& type, unsigned int sizeInBytes, unsigned int offsetInBytes)
+{
+	const uint32_t startTimestamp = ( m_Instrumentation ) ? m_Instrumentation->getTimestamp() : 0;
+
+	SharedData<uint8_t> data = m_StorageMedia.readFromMedia( sizeInBytes, offsetInBytes );
+
+	this->recordAccess( type, sizeInBytes, offsetInBytes );
+	this->recordLatency( type, sizeInBytes, offsetInBytes, startTimestamp );
+
+	return data;
+}
+
+void FatMediaIo::write (const FatIoType& type, const SharedData<uint8_t>& data, unsigned int offsetInBytes)
+{
+	const uint32_t startTimestamp = ( m_Instrumentation ) ? m_Instrumentation->getTimestamp() : 0;
+
+	m_StorageMedia.writeToMedia( data, offsetInBytes );
+
+	this->recordAccess( type, data.getSizeInBytes(), offsetInBytes );
+	this->recordLatency( type, data.getSizeInBytes(), offsetInBytes, startTimestamp );
+}
+
+void FatMediaIo::readAsync (const FatIoType& type, unsigned int sizeInBytes, unsigned int offsetInBytes, FatAsyncRequest& request)
+{
+	// the transfer is added first, since the media may complete it before returning
+	request.addTransfer();
+
+	if ( m_AsyncStorageMedia && m_AsyncStorageMedia->readFromMediaAsync(sizeInBytes, offsetInBytes, request) )
+	{
+		this->recordAccess( type, sizeInBytes, offsetInBytes );
+
+		return;
+	}
+
+	request.completeTransfer( this->read(type, sizeInBytes, offsetInBytes) );
+}
+
+void FatMediaIo::writeAsync (const FatIoType& type, const SharedData<uint8_t>& data, unsigned int offsetInBytes, FatAsyncRequest& request)
+{
+	request.addTransfer();
+
+	if ( m_AsyncStorageMedia && m_AsyncStorageMedia->writeToMediaAsync(data, offsetInBytes, request) )
+	{
+		this->recordAccess( type, data.getSizeInBytes(), offsetInBytes );
+
+		return;
+	}
+
+	this->write( type, data, offsetInBytes );
+	request.completeTransfer( SharedData<uint8_t>::MakeSharedDataNull() );
+}
+
+FatIoStats FatMediaIo::getStats() const
+{
+	FatLockGuard statsGuard( m_StatsLock );
+
+	return m_Stats;
+}
+
+void FatMediaIo::resetStats()
+{
+	FatLockGuard statsGuard( m_StatsLock );
+
+	memset( &m_Stats, 0, sizeof(m_Stats) );
+}
+
+unsigned int FatMediaIo::formatStatsAsCsv (const FatIoStats& stats, char* buffer, unsigned int bufferSizeInBytes)
+{
+	if ( bufferSizeInBytes == 0 ) return 0;
+
+	unsigned int numChars = 0;
+	buffer[0] = '\0';
+
+	if ( ! appendToBuffer(buffer, bufferSizeInBytes, numChars, "type,accesses,bytes,last_offset,total_latency,max_latency") ) return numChars;
+	for ( unsigned int bucket = 0; bucket < FAT_IO_NUM_LATENCY_BUCKETS - 1; bucket++ )
+	{
+		if ( ! appendToBuffer(buffer, bufferSizeInBytes, numChars, ",latency_lt_2^%u", bucket) ) return numChars;
+	}
+	// the last bucket holds everything the others don't, however long it took
+	if ( ! appendToBuffer(buffer, bufferSizeInBytes, numChars, ",latency_ge_2^%u", FAT_IO_NUM_LATENCY_BUCKETS - 2) ) return numChars;
+
+	for ( unsigned int type = 0; type < FAT_IO_NUM_TYPES; type++ )
+	{
+		const FatIoTypeStats& typeStats = stats.types[type];
+		if ( ! appendToBuffer(buffer, bufferSizeInBytes, numChars, "\n%s,%lu,%llu,%lu,%llu,%lu", ioTypeNames[type],
+					static_cast<unsigned long>(typeStats.numAccesses), static_cast<unsigned long long>(typeStats.numBytes),
+					static_cast<unsigned long>(typeStats.lastOffsetInBytes), static_cast<unsigned long long>(typeStats.totalLatency),
+					static_cast<unsigned long>(typeStats.maxLatency)) )
+		{
+			return numChars;
+		}
+
+		for ( unsigned int bucket = 0; bucket < FAT_IO_NUM_LATENCY_BUCKETS; bucket++ )
+		{
+			if ( ! appendToBuffer(buffer, bufferSizeInBytes, numChars, ",%lu", static_cast<unsigned long>(typeStats.latencyHistogram[bucket])) )
+			{
+				return numChars;
+			}
+		}
+	}
+
+	return numChars;
+}
+
+void FatMediaIo::recordAccess (const FatIoType& type, unsigned int sizeInBytes, unsigned int offsetInBytes)
+{
+	FatLockGuard statsGuard( m_StatsLock );
+
+	FatIoTypeStats& typeStats = m_Stats.types[static_cast<unsigned int>( type )];
+	typeStats.numAccesses++;
+	typeStats.numBytes += sizeInBytes;
+	typeStats.lastOffsetInBytes = offsetInBytes;
+}
+
+void FatMediaIo::recordLatency (const FatIoType& type, unsigned int sizeInBytes, unsigned int offsetInBytes, uint32_t startTimestamp)
+{
+	if ( ! m_Instrumentation ) return;
+
+	const uint32_t latency = m_Instrumentation->getTimestamp() - startTimestamp;
+
+	// bucket n holds latencies below 2^n, which is just the number of significant bits in the latency
+	unsigned int bucket = ( latency == 0 ) ? 0 : 32 - __builtin_clz( latency );
+	if ( bucket >= FAT_IO_NUM_LATENCY_BUCKETS ) bucket = FAT_IO_NUM_LATENCY_BUCKETS - 1;
+
+	{
+		FatLockGuard statsGuard( m_StatsLock );
+
+		FatIoTypeStats& typeStats = m_Stats.types[static_cast<unsigned int>( type )];
+		typeStats.totalLatency += latency;
+		if ( latency > typeStats.maxLatency ) typeStats.maxLatency = latency;
+		typeStats.latencyHistogram[bucket]++;
+	}
+
+	m_Instrumentation->onStorageMediaAccess( type, offsetInBytes, sizeInBytes, latency );
+}
@@ -0,0 +1,251 @@
+#include "FatSectorCache.hpp"
+
+#include <string.h>
+
+#include "IAllocator.hpp"
+
+// strictly for allocator
+struct FAT_CACHED_MAX
+{
+	uint8_t data[122880];
+};
+
+FatSectorCache::FatSectorCache (FatMediaIo& mediaIo, IAllocator* allocator) :
+	m_MediaIo( mediaIo ),
+	m_Allocator( allocator ),
+	m_FatOffset( 0 ),
+	m_SectorSizeInBytes( 0 ),
+	m_NumSectorsPerFat( 0 ),
+	m_NumFats( 0 ),
+	m_NumPages( 0 ),
+	m_PagesSharedData( SharedData<uint8_t>::MakeSharedDataNull() ),
+	m_PagesPtr( nullptr ),
+	m_SectorToPage(),
+	m_PageToSector(),
+	m_PageReferenced(),
+	m_ClockHand( 0 ),
+	m_DirtySectors()
+{
+}
+
+FatSectorCache::~FatSectorCache()
+{
+	this->freePages();
+}
+
+void FatSectorCache::init (unsigned int fatOffset, unsigned int sectorSizeInBytes, unsigned int numSectorsPerFat, unsigned int numFats,
+				unsigned int numPages)
+{
+	this->freePages();
+
+	m_FatOffset = fatOffset;
+	m_SectorSizeInBytes = sectorSizeInBytes;
+	m_NumSectorsPerFat = numSectorsPerFat;
+	m_NumFats = numFats;
+
+	if ( numPages == FAT_SECTOR_CACHE_WHOLE_FAT || numPages > numSectorsPerFat ) numPages = numSectorsPerFat;
+
+	// the allocator hands out fixed size blocks, so a FAT that is too big for one is paged instead of overrunning it
+	if ( m_Allocator && numPages * sectorSizeInBytes > sizeof(FAT_CACHED_MAX) )
+	{
+		numPages = sizeof( FAT_CACHED_MAX ) / sectorSizeInBytes;
+	}
+
+	m_NumPages = numPages;
+	m_DirtySectors.setNumBits( numSectorsPerFat );
+	m_ClockHand = 0;
+}
+
+void FatSectorCache::allocatePages()
+{
+	const unsigned int numSectorsPerFat = m_NumSectorsPerFat;
+	const unsigned int sectorSizeInBytes = m_SectorSizeInBytes;
+	const unsigned int numPages = m_NumPages;
+
+	if ( ! this->isPaged() )
+	{
+		// every sector has the page of the same number, so the whole FAT is read with one sequential read, which can be used as
+		// is when there is no allocator to copy it to
+		SharedData<uint8_t> fatData = m_MediaIo.read( FatIoType::FAT_READ, numSectorsPerFat * sectorSizeInBytes, m_FatOffset );
+		if ( m_Allocator )
+		{
+			m_PagesPtr = reinterpret_cast<uint8_t*>( m_Allocator->allocate<FAT_CACHED_MAX>() );
+			memcpy( m_PagesPtr, fatData.getPtr(), numSectorsPerFat * sectorSizeInBytes );
+		}
+		else
+		{
+			m_PagesSharedData = fatData;
+			m_PagesPtr = m_PagesSharedData.getPtr();
+		}
+
+		m_SectorToPage.resize( numSectorsPerFat );
+		m_PageToSector.resize( numSectorsPerFat );
+		for ( unsigned int sector = 0; sector < numSectorsPerFat; sector++ )
+		{
+			m_SectorToPage[sector] = sector;
+			m_PageToSector[sector] = sector;
+		}
+
+		return;
+	}
+
+	if ( m_Allocator )
+	{
+		m_PagesPtr = reinterpret_cast<uint8_t*>( m_Allocator->allocate<FAT_CACHED_MAX>() );
+	}
+	else
+	{
+		m_PagesPtr = new uint8_t[numPages * sectorSizeInBytes];
+	}
+
+	m_SectorToPage.assign( numSectorsPerFat, FAT_SECTOR_CACHE_NO_PAGE );
+	m_PageToSector.assign( numPages, FAT_SECTOR_CACHE_NO_PAGE );
+	m_PageReferenced.assign( numPages, false );
+}
+
+const uint8_t* FatSectorCache::getSector (unsigned int sector)
+{
+	if ( ! m_PagesPtr )
+	{
+		this->allocatePages();
+	}
+
+	uint32_t page = m_SectorToPage[sector];
+	if ( page == FAT_SECTOR_CACHE_NO_PAGE )
+	{
+		page = this->loadSector( sector );
+	}
+	else if ( this->isPaged() )
+	{
+		m_PageReferenced[page] = true;
+	}
+
+	return &m_PagesPtr[page * m_SectorSizeInBytes];
+}
+
+const uint8_t* FatSectorCache::findSector (unsigned int sector) const
+{
+	if ( ! m_PagesPtr || m_SectorToPage[sector] == FAT_SECTOR_CACHE_NO_PAGE ) return nullptr;
+
+	return &m_PagesPtr[m_SectorToPage[sector] * m_SectorSizeInBytes];
+}
+
+uint8_t* FatSectorCache::getSectorForWrite (unsigned int sector)
+{
+	uint8_t* sectorPtr = const_cast<uint8_t*>( this->getSector(sector) );
+	m_DirtySectors.setBit( sector );
+
+	return sectorPtr;
+}
+
+void FatSectorCache::flush()
+{
+	unsigned int runStartSector = m_DirtySectors.findNextSetBit( 0 );
+	while ( runStartSector < m_NumSectorsPerFat )
+	{
+		unsigned int runEndSector = runStartSector + 1;
+		while ( runEndSector < m_NumSectorsPerFat && m_DirtySectors.isBitSet(runEndSector) )
+		{
+			m_DirtySectors.clearBit( runEndSector );
+			runEndSector++;
+		}
+		m_DirtySectors.clearBit( runStartSector );
+
+		this->writeSectorRun( runStartSector, runEndSector - runStartSector );
+
+		runStartSector = m_DirtySectors.findNextSetBit( runEndSector );
+	}
+}
+
+uint32_t FatSectorCache::loadSector (unsigned int sector)
+{
+	const uint32_t page = this->evictPage();
+
+	SharedData<uint8_t> sectorData = m_MediaIo.read( FatIoType::FAT_READ, m_SectorSizeInBytes,
+							m_FatOffset + (sector * m_SectorSizeInBytes) );
+	memcpy( &m_PagesPtr[page * m_SectorSizeInBytes], sectorData.getPtr(), m_SectorSizeInBytes );
+
+	m_SectorToPage[sector] = page;
+	m_PageToSector[page] = sector;
+	m_PageReferenced[page] = true;
+
+	return page;
+}
+
+uint32_t FatSectorCache::evictPage()
+{
+	// sweep the clock hand round, giving every recently referenced page a second chance
+	while ( true )
+	{
+		const uint32_t page = m_ClockHand;
+		m_ClockHand = ( m_ClockHand + 1 ) % m_NumPages;
+
+		const uint32_t sector = m_PageToSector[page];
+		if ( sector == FAT_SECTOR_CACHE_NO_PAGE ) return page;
+
+		if ( m_PageReferenced[page] )
+		{
+			m_PageReferenced[page] = false;
+
+			continue;
+		}
+
+		if ( m_DirtySectors.isBitSet(sector) )
+		{
+			m_DirtySectors.clearBit( sector );
+			this->writeSectorRun( sector, 1 );
+		}
+
+		m_SectorToPage[sector] = FAT_SECTOR_CACHE_NO_PAGE;
+		m_PageToSector[page] = FAT_SECTOR_CACHE_NO_PAGE;
+
+		return page;
+	}
+}
+
+void FatSectorCache::writeSectorRun (unsigned int startSector, unsigned int numSectors)
+{
+	const unsigned int runOffset = startSector * m_SectorSizeInBytes;
+	const unsigned int runSizeInBytes = numSectors * m_SectorSizeInBytes;
+
+	// when the whole FAT is held without an allocator and all of it is dirty, it can be written straight from the pages
+	SharedData<uint8_t> runData = m_PagesSharedData;
+	if ( this->isPaged() || m_Allocator || runSizeInBytes != m_PagesSharedData.getSizeInBytes() )
+	{
+		runData = SharedData<uint8_t>::MakeSharedData( runSizeInBytes );
+		uint8_t* runDataPtr = runData.getPtr();
+		for ( unsigned int sector = 0; sector < numSectors; sector++ )
+		{
+			const uint32_t page = m_SectorToPage[startSector + sector];
+			memcpy( &runDataPtr[sector * m_SectorSizeInBytes], &m_PagesPtr[page * m_SectorSizeInBytes], m_SectorSizeInBytes );
+		}
+	}
+
+	// the other copies of the FAT are only for redundancy, but they are kept in step
+	for ( unsigned int fat = 0; fat < m_NumFats; fat++ )
+	{
+		m_MediaIo.write( FatIoType::FAT_WRITE, runData, m_FatOffset + (fat * m_NumSectorsPerFat * m_SectorSizeInBytes) + runOffset );
+	}
+}
+
+void FatSectorCache::freePages()
+{
+	if ( m_PagesPtr && m_PagesSharedData.getSizeInBytes() == 0 )
+	{
+		if ( m_Allocator )
+		{
+			m_Allocator->free<FAT_CACHED_MAX>( reinterpret_cast<FAT_CACHED_MAX*>(m_PagesPtr) );
+		}
+		else
+		{
+			delete[] m_PagesPtr;
+		}
+	}
+
+	m_PagesSharedData = SharedData<uint8_t>::MakeSharedDataNull();
+	m_PagesPtr = nullptr;
+	m_NumPages = 0;
+	m_SectorToPage.clear();
+	m_PageToSector.clear();
+	m_PageReferenced.clear();
+}
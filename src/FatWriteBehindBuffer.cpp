@@ -0,0 +1,142 @@
+#include "FatWriteBehindBuffer.hpp"
+
+#include <algorithm>
+#include <string.h>
+
+#include "IAllocator.hpp"
+
+// strictly for allocator
+struct FAT_WRITE_BEHIND_MAX
+{
+	uint8_t bytes[FAT_WRITE_BEHIND_MAX_SIZE];
+};
+
+FatWriteBehindBuffer::FatWriteBehindBuffer (unsigned int sizeInBytes, IAllocator* allocator) :
+	m_Allocator( allocator ),
+	m_Bytes( nullptr ),
+	m_SizeInBytes( 0 ),
+	m_Head( 0 ),
+	m_Tail( 0 ),
+	m_NumBytesPushed( 0 ),
+	m_NumPushesRejected( 0 ),
+	m_HighWaterMarkInBytes( 0 ),
+	m_NumBatchesDrained( 0 ),
+	m_NumBytesDrained( 0 ),
+	m_DrainBatch( SharedData<uint8_t>::MakeSharedDataNull() )
+{
+	if ( m_Allocator && sizeInBytes > FAT_WRITE_BEHIND_MAX_SIZE ) sizeInBytes = FAT_WRITE_BEHIND_MAX_SIZE;
+
+	// anything smaller couldn't hold a whole sector, so could never be drained
+	if ( sizeInBytes < FAT_WRITE_BEHIND_MIN_SIZE ) sizeInBytes = FAT_WRITE_BEHIND_MIN_SIZE;
+
+	// a power of two size keeps the free running positions lined up with the buffer when they wrap around
+	m_SizeInBytes = 1u << ( 31 - __builtin_clz(sizeInBytes) );
+
+	if ( m_Allocator )
+	{
+		m_Bytes = m_Allocator->allocate<FAT_WRITE_BEHIND_MAX>()->bytes;
+	}
+	else
+	{
+		m_Bytes = new uint8_t[m_SizeInBytes];
+	}
+}
+
+FatWriteBehindBuffer::~FatWriteBehindBuffer()
+{
+	if ( m_Allocator )
+	{
+		m_Allocator->free<FAT_WRITE_BEHIND_MAX>( reinterpret_cast<FAT_WRITE_BEHIND_MAX*>(m_Bytes) );
+	}
+	else
+	{
+		delete[] m_Bytes;
+	}
+}
+
+bool FatWriteBehindBuffer::push (const uint8_t* data, unsigned int numBytes)
+{
+	const uint32_t head = m_Head.load( std::memory_order_relaxed );
+	const uint32_t numBytesQueued = head - m_Tail.load( std::memory_order_acquire );
+
+	if ( numBytes > m_SizeInBytes - numBytesQueued )
+	{
+		FatWriteBehindBuffer::addToCount( m_NumPushesRejected, 1 );
+
+		return false;
+	}
+
+	// the data may wrap around the end of the buffer
+	const unsigned int headIndex = head & ( m_SizeInBytes - 1 );
+	const unsigned int numBytesBeforeEnd = std::min( numBytes, m_SizeInBytes - headIndex );
+	memcpy( &m_Bytes[headIndex], data, numBytesBeforeEnd );
+	memcpy( &m_Bytes[0], data + numBytesBeforeEnd, numBytes - numBytesBeforeEnd );
+
+	// publish the data to the consumer only once it has been copied in
+	m_Head.store( head + numBytes, std::memory_order_release );
+
+	FatWriteBehindBuffer::addToCount( m_NumBytesPushed, numBytes );
+	if ( numBytesQueued + numBytes > m_HighWaterMarkInBytes.load(std::memory_order_relaxed) )
+	{
+		m_HighWaterMarkInBytes.store( numBytesQueued + numBytes, std::memory_order_relaxed );
+	}
+
+	return true;
+}
+
+unsigned int FatWriteBehindBuffer::getNumBytesQueued() const
+{
+	return m_Head.load( std::memory_order_acquire ) - m_Tail.load( std::memory_order_relaxed );
+}
+
+void FatWriteBehindBuffer::peek (uint8_t* data, unsigned int numBytes) const
+{
+	const uint32_t tail = m_Tail.load( std::memory_order_relaxed );
+
+	const unsigned int tailIndex = tail & ( m_SizeInBytes - 1 );
+	const unsigned int numBytesBeforeEnd = std::min( numBytes, m_SizeInBytes - tailIndex );
+	memcpy( data, &m_Bytes[tailIndex], numBytesBeforeEnd );
+	memcpy( data + numBytesBeforeEnd, &m_Bytes[0], numBytes - numBytesBeforeEnd );
+}
+
+void FatWriteBehindBuffer::discard (unsigned int numBytes)
+{
+	// hand the space back to the producer only once the data is no longer needed
+	m_Tail.store( m_Tail.load(std::memory_order_relaxed) + numBytes, std::memory_order_release );
+
+	FatWriteBehindBuffer::addToCount( m_NumBatchesDrained, 1 );
+	FatWriteBehindBuffer::addToCount( m_NumBytesDrained, numBytes );
+}
+
+void FatWriteBehindBuffer::pop (uint8_t* data, unsigned int numBytes)
+{
+	this->peek( data, numBytes );
+	this->discard( numBytes );
+}
+
+SharedData<uint8_t>& FatWriteBehindBuffer::getDrainBatch (unsigned int sizeInBytes)
+{
+	if ( m_DrainBatch.getSizeInBytes() != sizeInBytes )
+	{
+		m_DrainBatch = SharedData<uint8_t>::MakeSharedData( sizeInBytes );
+	}
+
+	return m_DrainBatch;
+}
+
+FatWriteBehindStats FatWriteBehindBuffer::getStats() const
+{
+	FatWriteBehindStats stats;
+	stats.numBytesPushed = m_NumBytesPushed.load( std::memory_order_relaxed );
+	stats.numPushesRejected = m_NumPushesRejected.load( std::memory_order_relaxed );
+	stats.highWaterMarkInBytes = m_HighWaterMarkInBytes.load( std::memory_order_relaxed );
+	stats.numBatchesDrained = m_NumBatchesDrained.load( std::memory_order_relaxed );
+	stats.numBytesDrained = m_NumBytesDrained.load( std::memory_order_relaxed );
+
+	return stats;
+}
+
+void FatWriteBehindBuffer::addToCount (std::atomic<uint32_t>& count, uint32_t value)
+{
+	count.store( count.load(std::memory_order_relaxed) + value, std::memory_order_relaxed );
+}
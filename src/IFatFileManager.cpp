@@ -4,6 +4,7 @@
 
 IFatFileManager::IFatFileManager (IStorageMedia& storageMedia) :
 	m_StorageMedia( storageMedia ),
+	m_MediaIo( storageMedia ),
 	m_ActivePartitionNum( 0 ),
 	m_PartitionTables(),
 	m_ActiveBootSector( nullptr )
@@ -11,8 +12,8 @@ IFatFileManager::IFatFileManager (IStorageMedia& storageMedia) :
 	// load partition tables if Master Boot Record is present on storage media
 	if ( m_StorageMedia.hasMBR() )
 	{
-		// load all four partition tables
-		SharedData<uint8_t> pt = m_StorageMedia.readFromMedia( sizeof(uint32_t) * 4, PARTITION_TABLE_OFFSET );
+		// load all four partition tables, each of which is 16 bytes
+		SharedData<uint8_t> pt = m_StorageMedia.readFromMedia( sizeof(uint32_t) * 16, PARTITION_TABLE_OFFSET );
 		uint32_t* ptBuffer = reinterpret_cast<uint32_t*>( pt.getPtr() );
 
 		m_PartitionTables.push_back( PartitionTable(ptBuffer) );
@@ -0,0 +1,149 @@
+/**************************************************************************
+ * Checks every FatFreeScan kernel this CPU supports against the scalar
+ * kernels on random runs of FAT entries. The runs are every length up
+ * to a few hundred entries (so the tails that don't fill a whole step
+ * of a kernel are covered), start at unaligned addresses, range from
+ * almost all free to almost all used, and include FAT32 entries that
+ * only have their reserved top 4 bits set, which are still free. The
+ * random numbers come from a fixed seed, so a failure can be repeated.
+ * Returns non zero if any kernel disagrees with the scalar kernels.
+**************************************************************************/
+
+#include "FatFreeScan.hpp"
+
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define SCAN_TEST_SEED 			0x5CA11E55
+#define SCAN_TEST_MAX_NUM_ENTRIES 	300 // every length up to this is scanned
+#define SCAN_TEST_MAX_ALIGNMENT_OFFSET 	31 // bytes the first entry is moved past an aligned address
+#define SCAN_TEST_NUM_PASSES 		8
+#define SCAN_TEST_MASK_FILL 		0xA5A5A5A5 // what the free mask holds before a scan, so stale bits are caught
+
+typedef unsigned int (*ScanFunction) (const uint8_t* entries, unsigned int numEntries, uint32_t* freeMask);
+
+static const char* getKernelName (const FatFreeScanKernel& kernel)
+{
+	switch ( kernel )
+	{
+		case FatFreeScanKernel::SCALAR:
+			return "scalar";
+		case FatFreeScanKernel::SWAR:
+			return "swar";
+		case FatFreeScanKernel::SSE2:
+			return "sse2";
+		case FatFreeScanKernel::AVX2:
+			return "avx2";
+		case FatFreeScanKernel::NEON:
+			return "neon";
+	}
+
+	return "unknown";
+}
+
+// a used entry has at least one bit set, and often only one, so a kernel that only looks at some of the bytes is caught
+static void fillEntries (std::mt19937& random, uint8_t* entries, unsigned int numEntries, unsigned int entrySizeInBytes,
+				unsigned int percentFree)
+{
+	for ( unsigned int entryNum = 0; entryNum < numEntries; entryNum++ )
+	{
+		uint8_t* entry = &entries[entryNum * entrySizeInBytes];
+		memset( entry, 0, entrySizeInBytes );
+
+		if ( random() % 100 < percentFree )
+		{
+			// a FAT32 entry with only its reserved top 4 bits set is still free
+			if ( entrySizeInBytes == 4 && random() % 4 == 0 )
+			{
+				entry[3] = static_cast<uint8_t>( (random() % 15) + 1 ) << 4;
+			}
+		}
+		else if ( random() % 2 == 0 )
+		{
+			const unsigned int bitNum = random() % ( (entrySizeInBytes == 4) ? 28 : 16 );
+			entry[bitNum / 8] = static_cast<uint8_t>( 1 << (bitNum % 8) );
+		}
+		else
+		{
+			for ( unsigned int byte = 0; byte < entrySizeInBytes; byte++ )
+			{
+				entry[byte] = static_cast<uint8_t>( random() );
+			}
+
+			// the reserved bits alone don't make an entry used
+			if ( entrySizeInBytes == 4 && (entry[0] | entry[1] | entry[2] | (entry[3] & 0x0F)) == 0 ) entry[0] = 1;
+		}
+	}
+}
+
+static bool scansMatch (ScanFunction scan, ScanFunction scanScalar, const uint8_t* entries, unsigned int numEntries)
+{
+	const unsigned int numMaskWords = ( numEntries + 31 ) / 32;
+
+	// one more word than the scan needs, which neither kernel may touch
+	std::vector<uint32_t> freeMask( numMaskWords + 1, SCAN_TEST_MASK_FILL );
+	std::vector<uint32_t> freeMaskScalar( numMaskWords + 1, SCAN_TEST_MASK_FILL );
+
+	const unsigned int numFreeEntries = scan( entries, numEntries, freeMask.data() );
+	const unsigned int numFreeEntriesScalar = scanScalar( entries, numEntries, freeMaskScalar.data() );
+
+	return numFreeEntries == numFreeEntriesScalar && freeMask == freeMaskScalar && freeMask[numMaskWords] == SCAN_TEST_MASK_FILL;
+}
+
+static unsigned int testKernel (const FatFreeScanKernel& kernel, unsigned int entrySizeInBytes)
+{
+	const ScanFunction scan = ( entrySizeInBytes == 4 ) ? FatFreeScan::scanFat32 : FatFreeScan::scanFat16;
+	const ScanFunction scanScalar = ( entrySizeInBytes == 4 ) ? FatFreeScan::scanFat32Scalar : FatFreeScan::scanFat16Scalar;
+	const unsigned int percentsFree[] = { 0, 3, 50, 97, 100 };
+
+	std::mt19937 random( SCAN_TEST_SEED + entrySizeInBytes );
+	std::vector<uint8_t> buffer( (SCAN_TEST_MAX_NUM_ENTRIES * entrySizeInBytes) + SCAN_TEST_MAX_ALIGNMENT_OFFSET + 1 );
+	unsigned int numFailures = 0;
+
+	for ( unsigned int pass = 0; pass < SCAN_TEST_NUM_PASSES; pass++ )
+	{
+		for ( unsigned int numEntries = 0; numEntries <= SCAN_TEST_MAX_NUM_ENTRIES; numEntries++ )
+		{
+			const unsigned int alignmentOffset = random() % ( SCAN_TEST_MAX_ALIGNMENT_OFFSET + 1 );
+			const unsigned int percentFree = percentsFree[random() % ( sizeof(percentsFree) / sizeof(percentsFree[0]) )];
+			uint8_t* entries = &buffer[alignmentOffset];
+			fillEntries( random, entries, numEntries, entrySizeInBytes, percentFree );
+
+			if ( ! scansMatch(scan, scanScalar, entries, numEntries) )
+			{
+				printf( "FAIL: %s kernel, FAT%u, %u entries at offset %u, %u%% free\n", getKernelName(kernel),
+						entrySizeInBytes * 8, numEntries, alignmentOffset, percentFree );
+				numFailures++;
+			}
+		}
+	}
+
+	return numFailures;
+}
+
+int main()
+{
+	const FatFreeScanKernel defaultKernel = FatFreeScan::getKernel();
+	const FatFreeScanKernel kernels[] = { FatFreeScanKernel::SCALAR, FatFreeScanKernel::SWAR, FatFreeScanKernel::SSE2,
+						FatFreeScanKernel::AVX2, FatFreeScanKernel::NEON };
+	unsigned int numFailures = 0;
+
+	for ( const FatFreeScanKernel& kernel : kernels )
+	{
+		if ( ! FatFreeScan::setKernel(kernel) )
+		{
+			printf( "SKIP: %s kernel isn't supported\n", getKernelName(kernel) );
+			continue;
+		}
+
+		const unsigned int numFailuresForKernel = testKernel( kernel, 2 ) + testKernel( kernel, 4 );
+		printf( "%s: %s kernel\n", (numFailuresForKernel == 0) ? "PASS" : "FAIL", getKernelName(kernel) );
+		numFailures += numFailuresForKernel;
+	}
+
+	FatFreeScan::setKernel( defaultKernel );
+
+	return ( numFailures == 0 ) ? 0 : 1;
+}
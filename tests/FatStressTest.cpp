@@ -0,0 +1,444 @@
+/**************************************************************************
+ * Stress tests the locking of the Fat16FileManager against a
+ * RamStorageMedia. Several reader threads stream, seek and read at
+ * random offsets of the same files, one writer thread creates, fills
+ * and deletes files, and a browsing thread lists and searches the
+ * directory, all at once. This is run with the whole FAT in memory and
+ * with a paged FAT cache, and is best run under ThreadSanitizer as well.
+ * Writing over the middle of existing files, appending to them across
+ * a cluster boundary and past the end of a full chain are then checked
+ * on their own, as is writing over a file after a lazy remount. Returns non zero if any data
+ * read back doesn't match what was written.
+**************************************************************************/
+
+#include "Fat16FileManager.hpp"
+#include "RamStorageMedia.hpp"
+
+#include <atomic>
+#include <shared_mutex>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#define STRESS_VOLUME_SIZE 		( 16 * 1024 * 1024 )
+#define STRESS_NUM_SECTORS_PER_CLUSTER 	4
+#define STRESS_SECTOR_SIZE 		512
+#define STRESS_NUM_SOURCE_FILES 	3
+#define STRESS_SOURCE_FILE_SIZE 	( 300 * 1024 + 123 )
+#define STRESS_NUM_READERS 		4
+#define STRESS_NUM_READER_PASSES 	8
+#define STRESS_NUM_WRITER_FILES 	24
+#define STRESS_NUM_BROWSER_PASSES 	300
+#define STRESS_REMOUNT_FILE_SIZE 	1000
+#define STRESS_CLUSTER_SIZE 		( STRESS_NUM_SECTORS_PER_CLUSTER * STRESS_SECTOR_SIZE )
+
+class SharedMutexLock : public IFatLock
+{
+	public:
+		void lock() override { m_Mutex.lock(); }
+		void unlock() override { m_Mutex.unlock(); }
+		void lockShared() override { m_Mutex.lock_shared(); }
+		void unlockShared() override { m_Mutex.unlock_shared(); }
+
+	private:
+		std::shared_mutex m_Mutex;
+};
+
+static uint8_t getPatternByte (unsigned int fileNum, unsigned int offset)
+{
+	return static_cast<uint8_t>( (offset * 31) + (fileNum * 7) + (offset >> 9) );
+}
+
+static void makeFilename (char* filename, const char* prefix, unsigned int fileNum)
+{
+	snprintf( filename, FAT16_FILENAME_SIZE + 1, "%s%u", prefix, fileNum );
+}
+
+static bool matchesPattern (const uint8_t* data, unsigned int fileNum, unsigned int offset, unsigned int numBytes)
+{
+	for ( unsigned int byte = 0; byte < numBytes; byte++ )
+	{
+		if ( data[byte] != getPatternByte(fileNum, offset + byte) ) return false;
+	}
+
+	return true;
+}
+
+static bool writePatternFile (Fat16FileManager& fileManager, const char* filename, unsigned int fileNum, unsigned int sizeInBytes)
+{
+	Fat16FileHandle handle;
+	if ( ! fileManager.createEntry(Fat16Entry(filename, "BIN"), handle) ) return false;
+
+	// written in uneven chunks of whole sectors, then the rest
+	unsigned int offset = 0;
+	unsigned int chunkNum = 0;
+	while ( sizeInBytes - offset >= STRESS_SECTOR_SIZE )
+	{
+		const unsigned int numSectors = std::min( 1 + (chunkNum++ * 5) % 17, (sizeInBytes - offset) / STRESS_SECTOR_SIZE );
+		SharedData<uint8_t> chunk = SharedData<uint8_t>::MakeSharedData( numSectors * STRESS_SECTOR_SIZE );
+		for ( unsigned int byte = 0; byte < chunk.getSizeInBytes(); byte++ )
+		{
+			chunk[byte] = getPatternByte( fileNum, offset + byte );
+		}
+
+		if ( ! fileManager.writeToEntry(handle, chunk) ) return false;
+		offset += chunk.getSizeInBytes();
+	}
+
+	SharedData<uint8_t> tail = SharedData<uint8_t>::MakeSharedData( sizeInBytes - offset );
+	for ( unsigned int byte = 0; byte < tail.getSizeInBytes(); byte++ )
+	{
+		tail[byte] = getPatternByte( fileNum, offset + byte );
+	}
+
+	return fileManager.flushToEntry( handle, tail );
+}
+
+// writes numBytes of the given file's pattern at the offset of an existing file in the root directory, and makes the same change
+// to expectedData. An offset at the end of the file is written through openForAppend
+static bool writeToExistingFile (Fat16FileManager& fileManager, const char* filename, unsigned int offset, unsigned int fileNum,
+					unsigned int numBytes, std::vector<uint8_t>& expectedData)
+{
+	unsigned int entryNum = 0;
+	if ( ! fileManager.findEntry(filename, "BIN", entryNum) ) return false;
+
+	Fat16FileHandle handle;
+	const bool opened = ( offset == expectedData.size() ) ? fileManager.openForAppend( entryNum, handle )
+								: fileManager.openForWrite( entryNum, handle, offset );
+	if ( ! opened ) return false;
+
+	SharedData<uint8_t> data = SharedData<uint8_t>::MakeSharedData( numBytes );
+	if ( expectedData.size() < offset + numBytes ) expectedData.resize( offset + numBytes );
+	for ( unsigned int byte = 0; byte < numBytes; byte++ )
+	{
+		data[byte] = getPatternByte( fileNum, byte );
+		expectedData[offset + byte] = data[byte];
+	}
+
+	return fileManager.flushToEntry( handle, data );
+}
+
+static bool findFile (Fat16FileManager& fileManager, const char* filename, Fat16Entry& entry)
+{
+	char path[FAT16_FILENAME_SIZE + FAT16_EXTENSION_SIZE + 2];
+	snprintf( path, sizeof(path), "%s.BIN", filename );
+
+	// resolving a path doesn't move the 'cursor', so other threads can keep using the current directory
+	return fileManager.resolvePath( path, entry );
+}
+
+static bool readWholeFile (Fat16FileManager& fileManager, const Fat16Entry& entry, unsigned int fileNum, bool useReadAhead)
+{
+	Fat16FileHandle handle;
+	if ( useReadAhead ) fileManager.setReadAhead( handle, 4, 2 );
+	if ( ! fileManager.readEntry(entry, handle) ) return false;
+
+	unsigned int offset = 0;
+	SharedData<uint8_t> run = fileManager.getSelectedFileNextSectors( handle, 3 );
+	while ( run.getSizeInBytes() > 0 )
+	{
+		const unsigned int numBytesInFile = std::min( run.getSizeInBytes(), entry.getFileSizeInBytes() - offset );
+		if ( ! matchesPattern(&run[0], fileNum, offset, numBytesInFile) ) return false;
+
+		offset += run.getSizeInBytes();
+		run = fileManager.getSelectedFileNextSectors( handle, 3 );
+	}
+
+	return offset >= entry.getFileSizeInBytes();
+}
+
+static bool fileMatches (Fat16FileManager& fileManager, const char* filename, const std::vector<uint8_t>& expectedData)
+{
+	Fat16Entry entry( filename, "BIN" );
+	if ( ! findFile(fileManager, filename, entry) || entry.getFileSizeInBytes() != expectedData.size() ) return false;
+
+	Fat16FileHandle handle;
+	SharedData<uint8_t> data = SharedData<uint8_t>::MakeSharedDataNull();
+	if ( ! fileManager.readEntry(entry, handle) || ! fileManager.readAt(handle, 0, expectedData.size(), data) ) return false;
+
+	return data.getSizeInBytes() == expectedData.size() && memcmp( &data[0], expectedData.data(), expectedData.size() ) == 0;
+}
+
+static void runReader (Fat16FileManager& fileManager, unsigned int readerNum, std::atomic<unsigned int>& numFailures)
+{
+	uint8_t readBuffer[5000];
+
+	for ( unsigned int pass = 0; pass < STRESS_NUM_READER_PASSES; pass++ )
+	{
+		const unsigned int fileNum = ( readerNum + pass ) % STRESS_NUM_SOURCE_FILES;
+		char filename[FAT16_FILENAME_SIZE + 1];
+		makeFilename( filename, "SRC", fileNum );
+
+		Fat16Entry entry( filename, "BIN" );
+		if ( ! findFile(fileManager, filename, entry) || ! readWholeFile(fileManager, entry, fileNum, (readerNum % 2) == 1) )
+		{
+			numFailures++;
+			continue;
+		}
+
+		// random offsets through readAt and read, which both seek
+		Fat16FileHandle handle;
+		if ( ! fileManager.readEntry(entry, handle) )
+		{
+			numFailures++;
+			continue;
+		}
+
+		for ( unsigned int access = 0; access < 16; access++ )
+		{
+			const unsigned int offset = ( (access + 1) * 7919 * (readerNum + 3) ) % entry.getFileSizeInBytes();
+			const unsigned int numBytes = std::min( 1u + (access * 331) % 5000, entry.getFileSizeInBytes() - offset );
+
+			SharedData<uint8_t> data = SharedData<uint8_t>::MakeSharedDataNull();
+			if ( ! fileManager.readAt(handle, offset, numBytes, data) || data.getSizeInBytes() != numBytes
+					|| ! matchesPattern(&data[0], fileNum, offset, numBytes) )
+			{
+				numFailures++;
+			}
+
+			if ( ! fileManager.seek(handle, offset) || fileManager.read(handle, readBuffer, numBytes) != numBytes
+					|| ! matchesPattern(readBuffer, fileNum, offset, numBytes) )
+			{
+				numFailures++;
+			}
+		}
+	}
+}
+
+static void runWriter (Fat16FileManager& fileManager, std::atomic<unsigned int>& numFailures)
+{
+	char filename[FAT16_FILENAME_SIZE + 1];
+
+	for ( unsigned int fileNum = 0; fileNum < STRESS_NUM_WRITER_FILES; fileNum++ )
+	{
+		makeFilename( filename, "WR", fileNum );
+		if ( ! writePatternFile(fileManager, filename, 100 + fileNum, 10000 + (fileNum * 2741)) ) numFailures++;
+
+		// every third file is deleted again, so clusters are freed while others are being allocated
+		if ( fileNum % 3 == 2 )
+		{
+			makeFilename( filename, "WR", fileNum - 1 );
+			unsigned int entryNum = 0;
+			if ( ! fileManager.findEntry(filename, "BIN", entryNum) || ! fileManager.deleteEntry(entryNum) ) numFailures++;
+		}
+	}
+}
+
+static void runBrowser (Fat16FileManager& fileManager, std::atomic<unsigned int>& numFailures)
+{
+	char displayName[FAT16_FILENAME_SIZE + FAT16_EXTENSION_SIZE + 2];
+
+	for ( unsigned int pass = 0; pass < STRESS_NUM_BROWSER_PASSES; pass++ )
+	{
+		// the source files are never changed, so they must always be listed
+		unsigned int numSourceFilesListed = 0;
+		Fat16DirectoryView view = fileManager.getCurrentDirectoryView( true );
+		for ( unsigned int viewEntryNum = 0; viewEntryNum < view.getNumEntries(); viewEntryNum++ )
+		{
+			view.getEntry( viewEntryNum ).getFilenameDisplay( displayName );
+			if ( strncmp(displayName, "SRC", 3) == 0 ) numSourceFilesListed++;
+		}
+
+		if ( numSourceFilesListed != STRESS_NUM_SOURCE_FILES ) numFailures++;
+
+		unsigned int entryNum = 0;
+		if ( ! fileManager.findEntry("SRC1", "BIN", entryNum) ) numFailures++;
+
+		if ( pass % 50 == 0 )
+		{
+			fileManager.returnToRoot();
+			fileManager.getNumFreeClusters();
+		}
+	}
+}
+
+static unsigned int runStressTest (unsigned int numFatCachePages)
+{
+	RamStorageMedia media( STRESS_VOLUME_SIZE );
+	if ( ! media.formatFat16(STRESS_NUM_SECTORS_PER_CLUSTER) ) return 1;
+
+	SharedMutexLock fatLock;
+	SharedMutexLock directoryLock;
+	SharedMutexLock ioStatsLock;
+	std::atomic<unsigned int> numFailures( 0 );
+
+	Fat16FileManager fileManager( media, nullptr, numFatCachePages );
+	fileManager.setLocks( &fatLock, &directoryLock, &ioStatsLock );
+
+	char filename[FAT16_FILENAME_SIZE + 1];
+	for ( unsigned int fileNum = 0; fileNum < STRESS_NUM_SOURCE_FILES; fileNum++ )
+	{
+		makeFilename( filename, "SRC", fileNum );
+		if ( ! writePatternFile(fileManager, filename, fileNum, STRESS_SOURCE_FILE_SIZE + fileNum) ) return 1;
+	}
+	const unsigned int numFreeClustersBefore = fileManager.getNumFreeClusters();
+
+	std::vector<std::thread> threads;
+	for ( unsigned int readerNum = 0; readerNum < STRESS_NUM_READERS; readerNum++ )
+	{
+		threads.emplace_back( runReader, std::ref(fileManager), readerNum, std::ref(numFailures) );
+	}
+	threads.emplace_back( runWriter, std::ref(fileManager), std::ref(numFailures) );
+	threads.emplace_back( runBrowser, std::ref(fileManager), std::ref(numFailures) );
+
+	for ( std::thread& thread : threads )
+	{
+		thread.join();
+	}
+
+	// everything the writer left behind reads back whole, and deleting it gives back every cluster it took
+	for ( unsigned int fileNum = 0; fileNum < STRESS_NUM_WRITER_FILES; fileNum++ )
+	{
+		makeFilename( filename, "WR", fileNum );
+		Fat16Entry entry( filename, "BIN" );
+		const bool wasDeleted = ( fileNum % 3 == 1 );
+		if ( findFile(fileManager, filename, entry) == wasDeleted )
+		{
+			numFailures++;
+			continue;
+		}
+
+		if ( wasDeleted ) continue;
+
+		unsigned int entryNum = 0;
+		if ( entry.getFileSizeInBytes() != 10000 + (fileNum * 2741) || ! readWholeFile(fileManager, entry, 100 + fileNum, false)
+				|| ! fileManager.findEntry(filename, "BIN", entryNum) || ! fileManager.deleteEntry(entryNum) )
+		{
+			numFailures++;
+		}
+	}
+
+	if ( fileManager.getNumFreeClusters() != numFreeClustersBefore ) numFailures++;
+
+	return numFailures;
+}
+
+static unsigned int getNumClustersForSize (unsigned int sizeInBytes)
+{
+	return ( sizeInBytes + STRESS_CLUSTER_SIZE - 1 ) / STRESS_CLUSTER_SIZE;
+}
+
+static std::vector<uint8_t> makePatternData (unsigned int fileNum, unsigned int sizeInBytes)
+{
+	std::vector<uint8_t> data( sizeInBytes );
+	for ( unsigned int byte = 0; byte < sizeInBytes; byte++ )
+	{
+		data[byte] = getPatternByte( fileNum, byte );
+	}
+
+	return data;
+}
+
+// writes over the middle of a file, appends to it across a cluster boundary and appends to a file that fills its last cluster
+// (so the write starts past the end of its chain). After each, the files must read back whole and take no more clusters than
+// their sizes need
+static unsigned int runWriteOverTest()
+{
+	RamStorageMedia media( STRESS_VOLUME_SIZE );
+	if ( ! media.formatFat16(STRESS_NUM_SECTORS_PER_CLUSTER) ) return 1;
+
+	Fat16FileManager fileManager( media );
+	const unsigned int numFreeClustersBefore = fileManager.getNumFreeClusters();
+
+	std::vector<uint8_t> partialFileData = makePatternData( 60, (3 * STRESS_CLUSTER_SIZE) + 700 );
+	std::vector<uint8_t> fullFileData = makePatternData( 70, 2 * STRESS_CLUSTER_SIZE );
+	if ( ! writePatternFile(fileManager, "PARTIAL", 60, partialFileData.size())
+			|| ! writePatternFile(fileManager, "FULL", 70, fullFileData.size()) )
+	{
+		return 1;
+	}
+
+	unsigned int numFailures = 0;
+	const unsigned int numCases = 4;
+	for ( unsigned int caseNum = 0; caseNum < numCases; caseNum++ )
+	{
+		bool wroteFile = false;
+		switch ( caseNum )
+		{
+			case 0:
+				// part way through a sector, across a cluster boundary and part way through another sector
+				wroteFile = writeToExistingFile( fileManager, "PARTIAL", STRESS_CLUSTER_SIZE - 48, 61, 1500, partialFileData );
+				break;
+			case 1:
+				// over the last sector and on past the end of the file, without needing another cluster
+				wroteFile = writeToExistingFile( fileManager, "PARTIAL", partialFileData.size() - 100, 62, 600, partialFileData );
+				break;
+			case 2:
+				// across a cluster boundary, ending exactly on the next one
+				wroteFile = writeToExistingFile( fileManager, "PARTIAL", partialFileData.size(), 63,
+									(5 * STRESS_CLUSTER_SIZE) - partialFileData.size(), partialFileData );
+				break;
+			case 3:
+				wroteFile = writeToExistingFile( fileManager, "FULL", fullFileData.size(), 71, 1000, fullFileData );
+				break;
+		}
+
+		const unsigned int numClustersUsed = getNumClustersForSize( partialFileData.size() ) + getNumClustersForSize( fullFileData.size() );
+		if ( ! wroteFile || ! fileMatches(fileManager, "PARTIAL", partialFileData) || ! fileMatches(fileManager, "FULL", fullFileData)
+				|| fileManager.getNumFreeClusters() != numFreeClustersBefore - numClustersUsed )
+		{
+			printf( "FAIL: writing over an existing file, case %u\n", caseNum );
+			numFailures++;
+		}
+	}
+
+	return numFailures;
+}
+
+static unsigned int runRemountTest()
+{
+	RamStorageMedia media( STRESS_VOLUME_SIZE );
+	if ( ! media.formatFat16(STRESS_NUM_SECTORS_PER_CLUSTER) ) return 1;
+
+	std::vector<uint8_t> expectedData = makePatternData( 50, STRESS_REMOUNT_FILE_SIZE );
+
+	{
+		Fat16FileManager fileManager( media );
+		if ( ! writePatternFile(fileManager, "REMOUNT", 50, STRESS_REMOUNT_FILE_SIZE) ) return 1;
+	}
+
+	// only the boot sector is read up front by a lazy mount, so the free cluster index isn't built yet when the file is opened
+	unsigned int numFailures = 0;
+	{
+		Fat16FileManager fileManager( media, nullptr, FAT_SECTOR_CACHE_WHOLE_FAT, nullptr, FatMountPolicy::LAZY );
+		if ( ! writeToExistingFile(fileManager, "REMOUNT", STRESS_REMOUNT_FILE_SIZE, 51, 10, expectedData) ) numFailures++;
+	}
+
+	unsigned int numFreeClusters = 0;
+	{
+		Fat16FileManager fileManager( media, nullptr, FAT_SECTOR_CACHE_WHOLE_FAT, nullptr, FatMountPolicy::LAZY );
+		if ( ! writeToExistingFile(fileManager, "REMOUNT", 300, 52, 50, expectedData) ) numFailures++;
+		if ( ! fileMatches(fileManager, "REMOUNT", expectedData) ) numFailures++;
+		numFreeClusters = fileManager.getNumFreeClusters();
+	}
+
+	Fat16FileManager fileManager( media );
+	if ( ! fileMatches(fileManager, "REMOUNT", expectedData) || fileManager.getNumFreeClusters() != numFreeClusters ) numFailures++;
+
+	return numFailures;
+}
+
+int main()
+{
+	unsigned int numFailures = 0;
+
+	const unsigned int fatCachePageCounts[] = { FAT_SECTOR_CACHE_WHOLE_FAT, 4 };
+	for ( unsigned int numFatCachePages : fatCachePageCounts )
+	{
+		const unsigned int numFailuresInRun = runStressTest( numFatCachePages );
+		printf( "%s: %u failures with %u FAT cache pages\n", (numFailuresInRun == 0) ? "PASS" : "FAIL", numFailuresInRun,
+				numFatCachePages );
+		numFailures += numFailuresInRun;
+	}
+
+	const unsigned int numWriteOverFailures = runWriteOverTest();
+	printf( "%s: %u failures writing over existing files\n", (numWriteOverFailures == 0) ? "PASS" : "FAIL", numWriteOverFailures );
+	numFailures += numWriteOverFailures;
+
+	const unsigned int numRemountFailures = runRemountTest();
+	printf( "%s: %u failures writing over a file after a lazy remount\n", (numRemountFailures == 0) ? "PASS" : "FAIL", numRemountFailures );
+	numFailures += numRemountFailures;
+
+	return ( numFailures == 0 ) ? 0 : 1;
+}